@@ -0,0 +1,110 @@
+#!/bin/sh
+# Linux release build with profile-guided optimization and LTO.
+#
+#   ./build_pgo.sh [recording...]
+#
+# Builds a plain -O2 binary and an instrumented one, trains the instrumented one headlessly on
+# the given recordings (see -record) and the raster benchmarks, then rebuilds with the profile
+# and LTO into build/raster and compares it against the plain build. Works with GCC and Clang,
+# pick one with CXX. SDL2 comes from pkg-config unless SDL2_CFLAGS/SDL2_LIBS say otherwise.
+
+set -e
+
+cd "$(dirname "$0")"
+
+CXX=${CXX:-g++}
+SDL2_CFLAGS=${SDL2_CFLAGS:-$(pkg-config --cflags sdl2 | sed 's|/SDL2\b||g')}
+SDL2_LIBS=${SDL2_LIBS:-$(pkg-config --libs sdl2)}
+CXXFLAGS="-std=c++14 -O2 -DNDEBUG -Wall -Wno-missing-field-initializers $SDL2_CFLAGS $CXXFLAGS"
+LIBS="$SDL2_LIBS -lm -lpthread -lrt"
+FILES="code/*.cpp"
+
+BENCH_RUNS=${BENCH_RUNS:-200}
+PROFILE_DIR="$PWD/build/pgo"
+
+# @Note: Headless, the dummy video driver only has the software renderer which is all a
+# replay needs.
+export SDL_VIDEODRIVER=dummy
+
+if $CXX --version | grep -q clang; then
+    PROFILE_GENERATE="-fprofile-generate=$PROFILE_DIR"
+    PROFILE_USE="-fprofile-use=$PROFILE_DIR/raster.profdata -Wno-profile-instr-unprofiled"
+    LTO="-flto=thin"
+else
+    # @Note: The worker thread runs the engines too, without atomic updates its counts get lost.
+    PROFILE_GENERATE="-fprofile-generate -fprofile-update=atomic -fprofile-dir=$PROFILE_DIR"
+    PROFILE_USE="-fprofile-use -fprofile-partial-training -fprofile-dir=$PROFILE_DIR"
+    LTO="-flto=auto"
+fi
+
+mkdir -p build
+rm -rf "$PROFILE_DIR"
+
+echo "[INFO]: Building the plain binary"
+$CXX $CXXFLAGS $FILES -o build/raster_plain $LIBS
+
+# @Note: GCC names the profile of every file after the binary, the instrumented build has to
+# go where the final one will.
+echo "[INFO]: Building the instrumented binary"
+$CXX $CXXFLAGS $PROFILE_GENERATE $FILES -o build/raster $LIBS
+
+# @Note: Every engine and mode on the recordings, the benchmarks on the default shape and a
+# generated scene big enough for the multi group paths of the tiled engine.
+train()
+{
+    for recording in "$@"; do
+        for engine in reference tiled; do
+            for mode in worker incremental; do
+                ./build/raster -engine $engine -mode $mode -replay "$recording" > /dev/null
+            done
+        done
+    done
+
+    ./build/raster -bench $BENCH_RUNS > /dev/null
+    ./build/raster -bench $BENCH_RUNS -generate 2000 -seed 7 -holes 3 -curves 0.3 > /dev/null
+    ./build/raster -diff 2000 > /dev/null
+}
+
+echo "[INFO]: Training on $# recordings and the benchmarks"
+if [ $# -eq 0 ]; then echo "[WARNING]: No recordings given, the replay path only gets trained through the benchmarks"; fi
+train "$@"
+
+if $CXX --version | grep -q clang; then
+    llvm-profdata merge -o "$PROFILE_DIR/raster.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "[INFO]: Building the PGO+LTO binary"
+$CXX $CXXFLAGS $PROFILE_USE $LTO $FILES -o build/raster $LIBS
+
+# @Note: Same runs with both binaries, alternating a few rounds and keeping the best ns/run of
+# each engine so one noisy round doesn't decide it. Reports the speedup of the PGO build.
+compare()
+{
+    rm -f build/bench_plain.txt build/bench_pgo.txt
+    for round in 1 2 3; do
+        ./build/raster_plain -bench $BENCH_RUNS "$@" >> build/bench_plain.txt
+        ./build/raster -bench $BENCH_RUNS "$@" >> build/bench_pgo.txt
+    done
+
+    for name in reference tiled preview; do
+        plain=$(awk -v name=$name '$2 == name && (best == "" || $3 < best) { best = $3 } END { print best }' build/bench_plain.txt)
+        pgo=$(awk -v name=$name '$2 == name && (best == "" || $3 < best) { best = $3 } END { print best }' build/bench_pgo.txt)
+        awk -v name=$name -v plain=$plain -v pgo=$pgo 'BEGIN { printf("[INFO]:   %-10s %12.1f -> %12.1f ns/run, %.2fx\n", name, plain, pgo, plain / pgo) }'
+    done
+}
+
+echo "[INFO]: Default shape"
+compare
+echo "[INFO]: Generated scene, 10000 vertices"
+compare -generate 10000 -seed 11
+
+for recording in "$@"; do
+    echo "[INFO]: Replay of '$recording'"
+    for binary in raster_plain raster; do
+        printf "[INFO]:   %-12s raster " $binary
+        ./build/$binary -replay "$recording" | sed -n 's/^\[INFO\]: Raster  //p'
+    done
+done
+
+rm -f build/bench_plain.txt build/bench_pgo.txt
+echo "[INFO]: Done, build/raster is the PGO+LTO build"
@@ -5,18 +5,47 @@
 #include <math.h>
 #include <assert.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <linux/futex.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#define RASTER_POSIX
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
 #include <SDL2/SDL.h>
 
-typedef uint32_t u32;
-typedef uint8_t  u8;
-typedef int32_t  s32;
-typedef float    f32;
+#include "raster_kernels.h"
 
 #define UNUSED(x) ((void)(x))
 #define ERROR_EXIT(err, msg, ...)                   \
     do {                                            \
         if ((err)) {                                \
-            fprintf(stderr, (msg), __VA_ARGS__);    \
+            fprintf(stderr, (msg), ##__VA_ARGS__);  \
             exit(1);                                \
         }                                           \
     } while(0)                                      \
@@ -35,10 +64,37 @@ typedef float    f32;
 #define RECT_ROWS (WIDTH / RECT_RES)
 #define RECT_COLS (HEIGHT / RECT_RES)
 #define CIRCLE_RADIUS 15
-#define LINES_MAX 32
+#define VERTEX_HANDLES_MAX 256
+
+// @Note: Vertex positions are stored in 24.8 fixed point, in units of grid cells,
+// so 'FIXED_ONE' is one cell and the sample of a cell sits at 'FIXED_HALF'.
+#define FIXED_SHIFT 8
+#define FIXED_ONE (1 << FIXED_SHIFT)
+#define FIXED_HALF (FIXED_ONE / 2)
+#define FIXED_FROM_CELLS(x) ((s32) (x) * FIXED_ONE)
+
+#define TILE_SIZE 8
+#define TILE_ROWS ((RECT_ROWS + TILE_SIZE - 1) / TILE_SIZE)
+#define TILE_COLS ((RECT_COLS + TILE_SIZE - 1) / TILE_SIZE)
+#define TILE_AT(arr, row, col) ((arr)[TILE_COLS * (row) + (col)])
+
+// @Note: Worst case is every other cell being filled.
+#define ROW_SPANS_MAX ((RECT_ROWS + 1) / 2)
+#define SPANS_MAX (ROW_SPANS_MAX * RECT_COLS)
+#define COVERAGE_FULL 255
+#define FILLED_COLOR 0xFF007800
+
+#define INCREMENTAL_BUDGET_MS (MS_PER_FRAME / 4)
 
-#define internal static
-#define global static
+// @Note: While dragging we only take one sample per PREVIEW_FACTOR x PREVIEW_FACTOR cells,
+// full resolution follows once the pointer rests for PREVIEW_IDLE_MS or gets released.
+#define PREVIEW_FACTOR 4
+#define PREVIEW_FACTOR_MAX 8
+#define PREVIEW_IDLE_MS 100
+#define STATS_INTERVAL_MS 250
+
+#define MASK_WORDS ((RECT_ROWS + 63) / 64)
+#define MASK_AT(arr, x, y) ((arr)[MASK_WORDS * (y) + ((x) / 64)])
 
 struct Render_Ctx {
     SDL_Window *window;
@@ -52,10 +108,11 @@ struct Vec2f {
 
 // @ToDo: Better representation of a directed graph?
 struct Line {
-    u32 x0;
-    u32 y0;
-    u32 x1;
-    u32 y1;
+    // @Note: All in 24.8 fixed point, see 'FIXED_SHIFT'.
+    s32 x0;
+    s32 y0;
+    s32 x1;
+    s32 y1;
 
     // @Note: Connections are supposed to _always_ be clockwise.
     // We are working under that assumption in most of the code.
@@ -65,19 +122,645 @@ struct Line {
     size_t prev;
 };
 
+// @Note: Can hold any number of closed paths, every one of them is its own loop
+// through 'next'/'prev'. Grows on demand, see 'line_array_add'.
 struct Line_Array {
-    Line data[LINES_MAX];
+    Line *data;
+    size_t size;
+    size_t capacity;
+
+    // @Note: 'data' isn't ours (a mapped scene, a shared memory slot), it never gets freed and
+    // the first time it has to grow it moves to memory of our own.
+    bool borrowed;
+};
+
+// @Note: Everything before RASTER_ENGINE_AUTO is an actual engine, auto picks one of them.
+enum Raster_Engine {
+    RASTER_ENGINE_REFERENCE = 0,
+    RASTER_ENGINE_TILED,
+    RASTER_ENGINE_AUTO,
+    RASTER_ENGINE_COUNT,
+};
+
+global const char *raster_engine_names[RASTER_ENGINE_COUNT] = {
+    "reference",
+    "tiled",
+    "auto",
+};
+
+// @Note: What an engine has to do for a shape, only the rows being rasterized count.
+struct Shape_Features {
+    f64 edges;
+    f64 cells;
+    f64 bands;
+    f64 perimeter;
+};
+
+// @Note: Least squares fit of 'ns = intercept + slope * work' for one engine, see 'engine_work'.
+// The sums decay by AUTO_DECAY with every sample so the fit follows what the machine does now.
+struct Engine_Fit {
+    f64 n;
+    f64 sum_w;
+    f64 sum_t;
+    f64 sum_ww;
+    f64 sum_wt;
+
+    f64 intercept;
+    f64 slope;
+};
+
+struct Auto_Engine {
+    SDL_SpinLock lock;
+    Engine_Fit fits[RASTER_ENGINE_AUTO];
+    u32 decisions;
+    u32 chosen[RASTER_ENGINE_AUTO];
+    f64 error_total;
+    u32 measured;
+
+    // @Note: The last decision, for the stats.
+    Raster_Engine last_engine;
+    f32 last_predicted_ms;
+    f32 last_actual_ms;
+};
+
+// @Note: Shared by every thread that rasterizes, only touched under 'lock'.
+global Auto_Engine auto_engine;
+
+// @Note: Best first, picked at startup by 'raster_kernels_select' out of the ones the CPU has.
+global const Raster_Kernels *kernel_variants[] = {
+#ifdef RASTER_KERNELS_X86
+    &raster_kernels_avx512,
+    &raster_kernels_avx2,
+    &raster_kernels_sse41,
+    &raster_kernels_sse2,
+#endif
+    &raster_kernels_scalar,
+};
+
+global const Raster_Kernels *kernels = &raster_kernels_scalar;
+
+internal bool raster_kernels_supported(const Raster_Kernels *variant)
+{
+#ifdef RASTER_KERNELS_X86
+    if (variant == &raster_kernels_avx512) return(SDL_HasAVX512F() == SDL_TRUE);
+    if (variant == &raster_kernels_avx2) return(SDL_HasAVX2() == SDL_TRUE);
+    if (variant == &raster_kernels_sse41) return(SDL_HasSSE41() == SDL_TRUE);
+    if (variant == &raster_kernels_sse2) return(SDL_HasSSE2() == SDL_TRUE);
+#endif
+    return(variant == &raster_kernels_scalar);
+}
+
+// @Note: Picks the best variant the CPU has, or 'forced' when it names one. Forcing one the CPU
+// doesn't have falls back to the best with a warning instead of crashing on the first frame.
+// Returns false when 'forced' isn't the name of any variant.
+internal bool raster_kernels_select(const char *forced)
+{
+    const Raster_Kernels *best = 0;
+    const Raster_Kernels *wanted = 0;
+    
+    for (size_t i = 0; i < ARRAY_LEN(kernel_variants); ++i) {
+        if (!best && raster_kernels_supported(kernel_variants[i])) best = kernel_variants[i];
+        if (forced && strcmp(kernel_variants[i]->name, forced) == 0) wanted = kernel_variants[i];
+    }
+    
+    if (forced && !wanted) return(false);
+    
+    kernels = best;
+    if (wanted && raster_kernels_supported(wanted)) {
+        kernels = wanted;
+    } else if (wanted) {
+        fprintf(stderr, "[WARNING]: This CPU can't run the '%s' raster kernels, using '%s'\n", wanted->name, best->name);
+    }
+    
+    printf("[INFO]: Using '%s' raster kernels\n", kernels->name);
+    return(true);
+}
+
+// @Note: The tiled engine goes through the lines in groups of TILE_GROUP_LINES, bit 'i' is set
+// when line 'i' of the group crosses the tile, this is why a group can't have more lines than
+// bits in the mask. Same goes for the per-row cell masks of a tile.
+static_assert(TILE_GROUP_LINES <= 32, "Tile line masks are 32 bits wide");
+static_assert(TILE_SIZE <= 32, "Tile cell masks are 32 bits wide");
+
+// @Note: Bins of a single band of tiles (along y) for one group of lines.
+struct Tile_Bins {
+    u32 masks[TILE_ROWS];
+};
+
+// @Note: Instead of clearing the whole grid before every rasterization, each pass
+// gets a new epoch and a cell counts as filled only when it was stamped with the
+// current one. Whatever the previous pass wrote becomes stale for free.
+struct Raster_Grid {
+    u32 stamps[RECT_ROWS * RECT_COLS];
+    u32 epoch;
+};
+
+// @Note: Run of filled cells [x0, x1) on row 'y' (these are grid cells,
+// not fixed point), coverage goes from 0 to COVERAGE_FULL.
+struct Span {
+    s32 y;
+    s32 x0;
+    s32 x1;
+    u8 coverage;
+};
+
+struct Span_Row {
+    Span data[ROW_SPANS_MAX];
+    size_t size;
+};
+
+struct Span_Array {
+    Span data[SPANS_MAX];
     size_t size;
 };
 
-internal inline u32 sqr_distance(u32 x0, u32 y0, u32 x1, u32 y1)
+struct Rect_Batch {
+    SDL_Rect data[SPANS_MAX];
+    s32 size;
+};
+
+// @Note: One bit per cell, stored row by row (along y) so a scanline is
+// MASK_WORDS consecutive words.
+struct Coverage_Mask {
+    u64 words[MASK_WORDS * RECT_COLS];
+};
+
+// @Note: Presents a coverage mask through a streaming texture (one texel per cell),
+// only what changed since the last present gets converted and uploaded.
+struct Mask_Presenter {
+    SDL_Texture *texture;
+    u32 color;
+    Coverage_Mask previous;
+    Coverage_Mask diff;
+    u32 pixels[RECT_ROWS * RECT_COLS];
+
+    u32 changed_cells;
+    u32 uploaded_texels;
+};
+
+enum Span_Sink_Type {
+    SPAN_SINK_GRID = 0,
+    SPAN_SINK_MASK,
+    SPAN_SINK_SPANS,
+    SPAN_SINK_RECTS,
+    SPAN_SINK_FILE,
+};
+
+// @Note: Fill engines don't know where their output goes, they hand every
+// row of spans to the sink as soon as the row is done.
+struct Span_Sink {
+    Span_Sink_Type type;
+    union {
+        Raster_Grid *grid;
+        Coverage_Mask *mask;
+        Span_Array *spans;
+        Rect_Batch *rects;
+        FILE *file;
+    };
+
+    // @Note: Optional, when set the engine gets told to stop as soon as 'latest'
+    // moves past 'generation', meaning somebody already wants a newer result.
+    SDL_atomic_t *latest;
+    s32 generation;
+};
+
+#define ARENA_ALIGNMENT 64
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_PUSH_ARRAY(arena, type, count) ((type *) arena_push((arena), sizeof(type) * (count)))
+#define ARENA_PUSH_STRUCT(arena, type) ARENA_PUSH_ARRAY(arena, type, 1)
+
+struct Arena_Block {
+    Arena_Block *prev;
+    u8 *data;
+    size_t capacity;
+    size_t used;
+};
+
+// @Note: Bump allocator for everything that only lives as long as a frame or a raster job.
+// When a push doesn't fit another block gets chained on, the next reset swaps the chain for a
+// single block big enough for all of it. Once an arena has seen its biggest frame it doesn't
+// allocate anymore. Everything pushed is ARENA_ALIGNMENT aligned, enough for any SIMD load
+// and no two pushes share a cache line.
+struct Arena {
+    const char *name;
+    Arena_Block *block;
+    size_t used;
+    size_t high_water;
+};
+
+// @Note: Everything pushed after 'arena_begin_temp' goes away again with 'arena_end_temp'.
+struct Arena_Temp {
+    Arena *arena;
+    Arena_Block *block;
+    size_t block_used;
+    size_t used;
+};
+
+// @Note: Only ever touched by the UI thread, reset at the top of every frame.
+global Arena frame_arena = {"frame"};
+
+#define TRIPLE_BUFFER_FRESH 0x4
+#define TRIPLE_BUFFER_INDEX 0x3
+
+// @Note: Lock-free single producer/single consumer hand-off of the latest value. Producer
+// and consumer each own one of the three slots, the third one sits in 'middle'. Publishing
+// swaps the producer's slot into the middle (marked fresh), acquiring swaps the consumer's
+// slot out with it. Nobody ever waits and the consumer always gets the newest value.
+struct Triple_Buffer {
+    SDL_atomic_t middle;
+    s32 back;
+    s32 front;
+};
+
+struct Raster_Job {
+    Line_Array lines;
+    Raster_Engine engine;
+    s32 coarse;
+    s32 generation;
+};
+
+struct Raster_Result {
+    Coverage_Mask mask;
+    s32 coarse;
+    s32 generation;
+    f32 elapsed_ms;
+};
+
+// @Note: Rasterizes on its own thread so the event loop never waits on a slow shape.
+// The UI thread publishes immutable snapshots of the geometry, the worker writes into
+// the back result which gets swapped over to the UI once it's complete. Whatever job
+// the worker is on gets abandoned as soon as a newer one is submitted.
+struct Raster_Worker {
+    SDL_Thread *thread;
+    SDL_sem *wakeup;
+    SDL_atomic_t quit;
+    SDL_atomic_t latest_generation;
+    s32 submitted;
+
+    Raster_Job jobs[3];
+    Triple_Buffer job_buffer;
+    
+    Raster_Result results[3];
+    Triple_Buffer result_buffer;
+
+    // @Note: Worker thread only, reset for every job.
+    Arena arena;
+};
+
+// @Note: Rasterizes on the UI thread a slice (one band of TILE_SIZE rows) at a time
+// and gives control back once the frame's budget is used up, the next frame resumes at
+// 'next_y'. Rows that aren't done yet still show the previous shape.
+struct Incremental_Raster {
+    Line_Array lines;
+    Raster_Engine engine;
+    s32 coarse;
+    Coverage_Mask mask;
+    s32 next_y;
+    bool running;
+};
+
+enum Raster_Mode {
+    RASTER_MODE_WORKER = 0,
+    RASTER_MODE_INCREMENTAL,
+    RASTER_MODE_COUNT,
+};
+
+global const char *raster_mode_names[RASTER_MODE_COUNT] = {
+    "worker",
+    "incremental",
+};
+
+struct Raster_Ctx {
+    Raster_Mode mode;
+    Raster_Engine engine;
+    Raster_Worker worker;
+    Incremental_Raster incremental;
+
+    // @Note: Milliseconds, set once per frame. During a replay this is the recorded
+    // time and not the wall clock, so the preview refinement happens on the same frames.
+    u32 now;
+    
+    s32 preview_factor;
+    bool preview_pending;
+    u32 last_preview_ticks;
+
+    // @Note: Describes what's currently on screen.
+    s32 shown_coarse;
+    f32 shown_elapsed_ms;
+};
+
+enum Alloc_Phase {
+    ALLOC_PHASE_OTHER = 0,
+    ALLOC_PHASE_EVENTS,
+    ALLOC_PHASE_RASTER,
+    ALLOC_PHASE_PRESENT,
+    ALLOC_PHASE_WORKER,
+    ALLOC_PHASE_COUNT,
+};
+
+global const char *alloc_phase_names[ALLOC_PHASE_COUNT] = {
+    "other",
+    "events",
+    "raster",
+    "present",
+    "worker",
+};
+
+struct Alloc_Counts {
+    u64 allocations;
+    u64 bytes;
+    // @Note: Most bytes in use right after one of these allocations.
+    u64 peak;
+};
+
+struct Alloc_Frame {
+    Alloc_Counts total;
+    Alloc_Counts phases[ALLOC_PHASE_COUNT];
+};
+
+// @Note: Everything goes through the tracking allocator, SDL through 'SDL_SetMemoryFunctions',
+// our own code through SDL_malloc & co. and C++ through the replaced operator new.
+struct Alloc_Stats {
+    SDL_SpinLock lock;
+    u64 in_use;
+    u64 peak;
+    u64 allocations;
+    Alloc_Frame frame;
+};
+
+global Alloc_Stats alloc_stats;
+
+// @Note: What the current thread is doing, the worker thread is always in ALLOC_PHASE_WORKER.
+global thread_local Alloc_Phase alloc_phase;
+
+internal inline s64 sqr_distance(s32 x0, s32 y0, s32 x1, s32 y1)
+{
+    s64 dx = x1 - x0;
+    s64 dy = y1 - y0;
+    
+    return(dx*dx + dy*dy);
+}
+
+internal inline s32 screen_to_fixed(s32 p)
+{
+    return((p * FIXED_ONE) / RECT_RES);
+}
+
+internal inline s32 fixed_to_screen(s32 p)
+{
+    return((p * RECT_RES) / FIXED_ONE);
+}
+
+// @Note: Converts a [min, max] range of fixed point positions into the range of
+// cells whose sample falls inside of it, 'last' is exclusive.
+internal void get_sample_range(s32 min, s32 max, s32 cells, s32 *first, s32 *last)
+{
+    *first = (min + FIXED_HALF - 1) >> FIXED_SHIFT;
+    *last = (max + FIXED_HALF) >> FIXED_SHIFT;
+    *first = MAX(*first, 0);
+    *last = MIN(*last, cells);
+}
+
+// @Note: Every block carries its size in front so frees can be counted too, 16 bytes keep
+// what we hand out as aligned as what malloc gave us.
+#define ALLOC_HEADER_SIZE 16
+
+internal void alloc_stats_count(Alloc_Counts *counts, size_t size, u64 in_use)
+{
+    counts->allocations += 1;
+    counts->bytes += size;
+    counts->peak = MAX(counts->peak, in_use);
+}
+
+internal void alloc_stats_add(size_t size)
+{
+    SDL_AtomicLock(&alloc_stats.lock);
+    alloc_stats.in_use += size;
+    alloc_stats.peak = MAX(alloc_stats.peak, alloc_stats.in_use);
+    alloc_stats.allocations += 1;
+    alloc_stats_count(&alloc_stats.frame.total, size, alloc_stats.in_use);
+    alloc_stats_count(&alloc_stats.frame.phases[alloc_phase], size, alloc_stats.in_use);
+    SDL_AtomicUnlock(&alloc_stats.lock);
+}
+
+internal void alloc_stats_remove(size_t size)
+{
+    SDL_AtomicLock(&alloc_stats.lock);
+    alloc_stats.in_use -= size;
+    SDL_AtomicUnlock(&alloc_stats.lock);
+}
+
+internal void *SDLCALL tracked_malloc(size_t size)
+{
+    u8 *block = (u8 *) malloc(size + ALLOC_HEADER_SIZE);
+    if (!block) return(0);
+
+    *(size_t *) block = size;
+    alloc_stats_add(size);
+    return(block + ALLOC_HEADER_SIZE);
+}
+
+internal void *SDLCALL tracked_calloc(size_t count, size_t size)
+{
+    if (size != 0 && count > (SIZE_MAX - ALLOC_HEADER_SIZE) / size) return(0);
+    
+    void *memory = tracked_malloc(count * size);
+    if (memory) memset(memory, 0, count * size);
+    return(memory);
+}
+
+// @Note: Counts as a new allocation of the full size, even when it could grow in place.
+internal void *SDLCALL tracked_realloc(void *memory, size_t size)
+{
+    if (!memory) return(tracked_malloc(size));
+    
+    u8 *block = (u8 *) memory - ALLOC_HEADER_SIZE;
+    size_t old_size = *(size_t *) block;
+    
+    block = (u8 *) realloc(block, size + ALLOC_HEADER_SIZE);
+    if (!block) return(0);
+    
+    *(size_t *) block = size;
+    alloc_stats_remove(old_size);
+    alloc_stats_add(size);
+    return(block + ALLOC_HEADER_SIZE);
+}
+
+internal void SDLCALL tracked_free(void *memory)
+{
+    if (!memory) return;
+
+    u8 *block = (u8 *) memory - ALLOC_HEADER_SIZE;
+    alloc_stats_remove(*(size_t *) block);
+    free(block);
+}
+
+// @Note: Has to run before SDL allocates anything, SDL would otherwise free its own
+// blocks through us.
+internal void alloc_tracking_install(void)
+{
+    if (SDL_SetMemoryFunctions(tracked_malloc, tracked_calloc, tracked_realloc, tracked_free) != 0) {
+        fprintf(stderr, "[WARNING]: Could not install the tracking allocator, SDL's allocations won't be counted -> %s\n", SDL_GetError());
+    }
+}
+
+// @Note: Hands back what was allocated since the last call and starts counting the next frame.
+internal Alloc_Frame alloc_frame_end(void)
+{
+    SDL_AtomicLock(&alloc_stats.lock);
+    Alloc_Frame frame = alloc_stats.frame;
+    alloc_stats.frame = {};
+    alloc_stats.frame.total.peak = alloc_stats.in_use;
+    SDL_AtomicUnlock(&alloc_stats.lock);
+    
+    return(frame);
+}
+
+// @Note: C++ allocations, whatever the CRT or a library does through 'new' shows up in
+// the same counts.
+void *operator new(size_t size)
+{
+    void *memory = tracked_malloc(size ? size : 1);
+    ERROR_EXIT(memory == 0, "[ERROR]: Out of memory for %zu bytes\n", size);
+    return(memory);
+}
+
+void *operator new[](size_t size)
+{
+    return(operator new(size));
+}
+
+void operator delete(void *memory) noexcept { tracked_free(memory); }
+void operator delete[](void *memory) noexcept { tracked_free(memory); }
+void operator delete(void *memory, size_t size) noexcept { UNUSED(size); tracked_free(memory); }
+void operator delete[](void *memory, size_t size) noexcept { UNUSED(size); tracked_free(memory); }
+
+#define ALIGN_UP(x, a) (((x) + (a) - 1) & ~((size_t) (a) - 1))
+
+internal Arena_Block *arena_block_create(size_t capacity, Arena_Block *prev)
+{
+    // @Note: The header sits in front of the data, padded so the data starts aligned.
+    u8 *memory = (u8 *) SDL_malloc(sizeof(Arena_Block) + capacity + ARENA_ALIGNMENT);
+    ERROR_EXIT(memory == 0, "[ERROR]: Out of memory for a %zu byte arena block\n", capacity);
+
+    Arena_Block *block = (Arena_Block *) memory;
+    block->prev = prev;
+    block->data = (u8 *) ALIGN_UP((uintptr_t) (memory + sizeof(Arena_Block)), ARENA_ALIGNMENT);
+    block->capacity = capacity;
+    block->used = 0;
+    return(block);
+}
+
+internal void *arena_push(Arena *arena, size_t size)
+{
+    size = ALIGN_UP(MAX(size, 1), ARENA_ALIGNMENT);
+
+    Arena_Block *block = arena->block;
+    if (!block || block->used + size > block->capacity) {
+        size_t capacity = MAX(size, ARENA_BLOCK_SIZE);
+        if (block) capacity = MAX(capacity, 2 * block->capacity);
+        
+        block = arena_block_create(capacity, block);
+        arena->block = block;
+    }
+
+    void *memory = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    arena->high_water = MAX(arena->high_water, arena->used);
+    return(memory);
+}
+
+internal Arena_Temp arena_begin_temp(Arena *arena)
+{
+    Arena_Temp temp;
+    temp.arena = arena;
+    temp.block = arena->block;
+    temp.block_used = arena->block ? arena->block->used : 0;
+    temp.used = arena->used;
+    return(temp);
+}
+
+// @Note: Blocks chained on in between get dropped except for the newest (and biggest) one,
+// which stays around empty so doing the same thing again doesn't allocate.
+internal void arena_end_temp(Arena_Temp temp)
+{
+    Arena *arena = temp.arena;
+    Arena_Block *newest = arena->block;
+    
+    if (newest != temp.block) {
+        while (newest->prev != temp.block) {
+            Arena_Block *dropped = newest->prev;
+            newest->prev = dropped->prev;
+            SDL_free(dropped);
+        }
+        newest->used = 0;
+    }
+
+    if (temp.block) temp.block->used = temp.block_used;
+    arena->used = temp.used;
+}
+
+internal void arena_free(Arena *arena)
+{
+    while (arena->block) {
+        Arena_Block *prev = arena->block->prev;
+        SDL_free(arena->block);
+        arena->block = prev;
+    }
+    arena->used = 0;
+}
+
+// @Note: Throws away everything that was pushed, merging the blocks into one if it took more
+// than one. That's the only place other than a push that doesn't fit that allocates.
+internal void arena_reset(Arena *arena)
+{
+    if (arena->block && (arena->block->prev || arena->block->capacity < arena->high_water)) {
+        size_t capacity = ALIGN_UP(arena->high_water, ARENA_BLOCK_SIZE);
+        arena_free(arena);
+        arena->block = arena_block_create(capacity, 0);
+    }
+
+    if (arena->block) arena->block->used = 0;
+    arena->used = 0;
+}
+
+internal void line_array_reserve(Line_Array *lines, size_t capacity)
+{
+    if (capacity <= lines->capacity) return;
+
+    if (lines->borrowed) {
+        Line *data = (Line *) SDL_malloc(capacity * sizeof(Line));
+        ERROR_EXIT(data == 0, "[ERROR]: Out of memory for %zu lines\n", capacity);
+        if (lines->size > 0) memcpy(data, lines->data, lines->size * sizeof(Line));
+
+        lines->data = data;
+        lines->borrowed = false;
+    } else {
+        lines->data = (Line *) SDL_realloc(lines->data, capacity * sizeof(Line));
+        ERROR_EXIT(lines->data == 0, "[ERROR]: Out of memory for %zu lines\n", capacity);
+    }
+    lines->capacity = capacity;
+}
+
+internal void line_array_free(Line_Array *lines)
+{
+    if (!lines->borrowed) SDL_free(lines->data);
+    *lines = {};
+}
+
+// @Note: Snapshot of 'from', keeps reusing the memory 'to' already has. Takes on the whole
+// capacity of 'from' so snapshots only ever grow when the shape itself does.
+internal void line_array_copy(Line_Array *to, Line_Array *from)
 {
-    return((x1 - x0)*(x1 - x0) + (y1 - y0)*(y1 - y0));
+    line_array_reserve(to, from->capacity);
+    if (from->size > 0) memcpy(to->data, from->data, from->size * sizeof(Line));
+    to->size = from->size;
 }
 
 internal void line_array_add(Line_Array *lines, s32 x0, s32 y0, s32 x1, s32 y1)
 {
-    if (lines->size == LINES_MAX) return;
+    if (lines->size == lines->capacity) line_array_reserve(lines, MAX(lines->capacity * 2, 16));
    
     lines->data[lines->size].x0 = x0;
     lines->data[lines->size].y0 = y0;
@@ -97,7 +780,7 @@ internal void line_array_connect(Line_Array *lines, size_t which, size_t next, s
 }
 
 // @Note: We're describing a path going like so 'p0 -> p1 -> p2'
-internal void line_array_reconnect(Line_Array *lines, size_t p0, size_t p1, size_t p2, u32 x0, u32 y0)
+internal void line_array_reconnect(Line_Array *lines, size_t p0, size_t p1, size_t p2, s32 x0, s32 y0)
 {
     lines->data[p2].prev = p1;
     lines->data[p0].next = p1;
@@ -109,216 +792,6578 @@ internal void line_array_reconnect(Line_Array *lines, size_t p0, size_t p1, size
 // but just something to think about.
 internal bool check_intersection(Line line, Vec2f Bs, Vec2f Bd, f32 *t, f32 *u)
 {
-    Vec2f As = {(f32) line.x0, (f32) line.y0};
-    Vec2f Ad = {line.x1 - As.x, line.y1 - As.y};
+    // @Note: Done in doubles, every value here is a multiple of 1/FIXED_ONE so the products
+    // below are exact and the sign of 'u' can't get rounded the wrong way when the sample is
+    // right next to the line. With floats it did for long lines, see '-diff'.
+    f64 As_x = (f64) line.x0 / FIXED_ONE;
+    f64 As_y = (f64) line.y0 / FIXED_ONE;
+    f64 Ad_x = (f64) line.x1 / FIXED_ONE - As_x;
+    f64 Ad_y = (f64) line.y1 / FIXED_ONE - As_y;
 
     // @Note: For more information read the supplimentary paper 'Lines intersection.pdf', while trying to get
     // 'inspired' for this project I also found this amazing implementation, which might be helpful to some.
     //
     // https://github.com/leddoo/edu-vector-graphics/blob/master/src/main.rs
-    f32 det = -Ad.x*Bd.y + Ad.y*Bd.x;
-    if (det == 0.0f) return(false);
+    f64 det = -Ad_x*Bd.y + Ad_y*Bd.x;
+    if (det == 0.0) return(false);
 
-    *t = (1.0f/det) * (-Bd.y*(Bs.x - As.x) + Bd.x*(Bs.y - As.y));
-    *u = (1.0f/det) * (-Ad.y*(Bs.x - As.x) + Ad.x*(Bs.y - As.y));
+    *t = (f32) ((1.0/det) * (-Bd.y*(Bs.x - As_x) + Bd.x*(Bs.y - As_y)));
+    *u = (f32) ((1.0/det) * (-Ad_y*(Bs.x - As_x) + Ad_x*(Bs.y - As_y)));
 
     return(true);
 }
 
-// @ToDo: Add more fill rules to see how they work on different shapes.
-internal void rasterize_shape(Line_Array *lines, SDL_Rect *rects, SDL_Rect *filled_rects)
+// @Note: Casts a ray from the sample (in fixed point) towards negative x, this is the test every
+// fill engine has to agree with, so keep it in one place.
+//
+// Whether the ray is within the line's span along y is decided on the fixed point values and
+// is half-open, [min_y, max_y). With vertices off the cell grid a sample can sit exactly at
+// the height of a vertex, the half-open span makes sure we count the two lines meeting there
+// once when the path passes through and twice/zero times when it only touches the ray.
+internal inline bool ray_hits_line(Line line, s32 x, s32 y)
 {
-    memset(filled_rects, 0, sizeof(SDL_Rect)*RECT_ROWS*RECT_COLS);
-    
-    u32 min_x = lines->data[0].x0;
-    u32 max_x = lines->data[0].x0;
-    u32 min_y = lines->data[0].y0;
-    u32 max_y = lines->data[0].y0;
+    if ((line.y0 <= y) == (line.y1 <= y)) return(false);
+
+    f32 t, u;
+    Vec2f sample = {(f32) x / FIXED_ONE, (f32) y / FIXED_ONE};
+    if (!check_intersection(line, sample, {-1.0f, 0.0f}, &t, &u)) return(false);
+
+    // @Note: Our 'u >= 0' means that we don't care how much we stretch the 'other' line/ray.
+    return(u >= 0.0f);
+}
+
+// @Note: Same test as 'ray_hits_line' but done exactly on integers, this is what the optimized
+// engines use. Instead of dividing to get the intersection we compare cross-multiplied, the
+// products of two 24.8 values need 64 bits.
+internal inline bool ray_hits_line_fixed(Line line, s32 x, s32 y)
+{
+    if ((line.y0 <= y) == (line.y1 <= y)) return(false);
+
+    s64 lhs = (s64) (y - line.y0) * (line.x1 - line.x0);
+    s64 rhs = (s64) (x - line.x0) * (line.y1 - line.y0);
+
+    return(line.y1 > line.y0 ? lhs <= rhs : lhs >= rhs);
+}
+
+internal inline s32 cell_sample(s32 cell)
+{
+    return(FIXED_FROM_CELLS(cell) + FIXED_HALF);
+}
+
+internal void get_shape_bounds(Line_Array *lines, s32 *min_x, s32 *max_x, s32 *min_y, s32 *max_y)
+{
+    *min_x = *max_x = lines->data[0].x0;
+    *min_y = *max_y = lines->data[0].y0;
 
     for (size_t i = 1; i < lines->size; ++i) {
-        min_x = MIN(lines->data[i].x0, min_x);
-        max_x = MAX(lines->data[i].x0, max_x);
+        *min_x = MIN(lines->data[i].x0, *min_x);
+        *max_x = MAX(lines->data[i].x0, *max_x);
 
-        min_y = MIN(lines->data[i].y0, min_y);
-        max_y = MAX(lines->data[i].y0, max_y);
+        *min_y = MIN(lines->data[i].y0, *min_y);
+        *max_y = MAX(lines->data[i].y0, *max_y);
     }
-    
-    f32 t, u;    
-    for (u32 row = min_x; row < max_x; ++row) {
-        for (u32 col = min_y; col < max_y; ++col) { 
-            u32 intersections = 0;
-            for (size_t i = 0; i < lines->size; ++i) {
-                if (!check_intersection(lines->data[i], {row + 0.5f, col + 0.5f}, {-1.0f, 0.0f}, &t, &u)) continue;
-                
-                // @Note: Our 'u >= 0' means that we don't care how much we stretch the 'other' line/ray.
-                if (u >= 0.0f && (t >= 0.0f && t <= 1.0f)) intersections += 1;
-            }
+}
 
-            if (intersections % 2 != 0) ARRAY_AT(filled_rects, row, col) = ARRAY_AT(rects, row, col);
-        }
+internal void raster_grid_begin(Raster_Grid *grid)
+{
+    grid->epoch += 1;
+
+    // @Note: Once every 2^32 passes the epoch wraps, old stamps could then
+    // match again so this is the only time we pay for clearing everything.
+    if (grid->epoch == 0) {
+        memset(grid->stamps, 0, sizeof(grid->stamps));
+        grid->epoch = 1;
     }
 }
 
-internal s32 get_index_of_selected_origin(s32 mouse_x, s32 mouse_y, Line_Array *lines)
+internal inline void raster_grid_fill(Raster_Grid *grid, s32 row, s32 col)
 {
-    const s32 w = 2*CIRCLE_RADIUS;
-    
-    for (s32 i = 0; i < (s32) lines->size; ++i) {
-        s32 x = (s32) lines->data[i].x0 * RECT_RES - CIRCLE_RADIUS;
-        s32 y = (s32) lines->data[i].y0 * RECT_RES - CIRCLE_RADIUS;
-        
-        if ((mouse_x >= x && mouse_x <= x + w) &&
-            (mouse_y >= y && mouse_y <= y + w))
-        {
-            return(i);
-        }
-    }
+    ARRAY_AT(grid->stamps, row, col) = grid->epoch;
+}
 
-    return(-1);
+internal inline bool raster_grid_is_filled(Raster_Grid *grid, u32 index)
+{
+    return(grid->stamps[index] == grid->epoch);
 }
 
-internal void add_new_point(s32 mouse_x, s32 mouse_y, Line_Array *lines)
+internal void span_row_push(Span_Row *row, s32 y, s32 x0, s32 x1)
 {
-    assert(lines->size >= 3);
+    if (row->size > 0 && row->data[row->size - 1].x1 == x0) {
+        row->data[row->size - 1].x1 = x1;
+        return;
+    }
 
-    u32 x0 = (u32) ((f32) mouse_x/WIDTH * RECT_ROWS);
-    u32 y0 = (u32) ((f32) mouse_y/HEIGHT * RECT_COLS);
-    u32 x1 = lines->data[0].x0;
-    u32 y1 = lines->data[0].y0;
-    
-    u32 min_dist = sqr_distance(x0, y0, x1, y1); 
-    size_t index = 0;
+    assert(row->size < ROW_SPANS_MAX);
     
-    for (size_t i = 1; i < lines->size; ++i) {
-        x1 = lines->data[i].x0;
-        y1 = lines->data[i].y0;
-        u32 dist = sqr_distance(x0, y0, x1, y1);
+    Span span = {0};
+    span.y = y;
+    span.x0 = x0;
+    span.x1 = x1;
+    span.coverage = COVERAGE_FULL;
+    row->data[row->size++] = span;
+}
 
-        if (dist < min_dist) {
-            index = i;
-            min_dist = dist;
-        }
-    }
+internal inline u32 popcount64(u64 x)
+{
+#ifdef _MSC_VER
+    return((u32) __popcnt64(x));
+#else
+    return((u32) __builtin_popcountll(x));
+#endif
+}
+
+internal inline u32 lowest_set_bit64(u64 x)
+{
+    assert(x != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return((u32) index);
+#else
+    return((u32) __builtin_ctzll(x));
+#endif
+}
+
+internal inline u32 highest_set_bit64(u64 x)
+{
+    assert(x != 0);
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return((u32) index);
+#else
+    return(63 - (u32) __builtin_clzll(x));
+#endif
+}
+
+// @Note: Sets cells [x0, x1) on row y.
+internal void coverage_mask_fill(Coverage_Mask *mask, s32 y, s32 x0, s32 x1)
+{
+    while (x0 < x1) {
+        s32 bit = x0 % 64;
+        s32 count = MIN(64 - bit, x1 - x0);
+        u64 bits = (count == 64) ? ~0ull : ((1ull << count) - 1) << bit;
+
+        MASK_AT(mask->words, x0, y) |= bits;
+        x0 += count;
+    }
+}
+
+internal void mask_presenter_init(Mask_Presenter *presenter, SDL_Renderer *renderer)
+{
+    presenter->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, RECT_ROWS, RECT_COLS);
+    ERROR_EXIT(presenter->texture == 0, "[ERROR]: Could not create SDL2 texture -> %s\n", SDL_GetError());
+
+    // @Note: Empty cells are see-through so the grid underneath stays visible.
+    SDL_SetTextureBlendMode(presenter->texture, SDL_BLENDMODE_BLEND);
+    presenter->color = FILLED_COLOR;
+    
+    memset(presenter->previous.words, 0, sizeof(presenter->previous.words));
+    memset(presenter->pixels, 0, sizeof(presenter->pixels));
+    SDL_UpdateTexture(presenter->texture, 0, presenter->pixels, RECT_ROWS * sizeof(u32));
+}
+
+internal void mask_presenter_upload(Mask_Presenter *presenter, s32 y_first, s32 y_last, s32 x_first, s32 x_last)
+{
+    SDL_Rect rect = {0};
+    rect.x = x_first;
+    rect.y = y_first;
+    rect.w = x_last - x_first + 1;
+    rect.h = y_last - y_first + 1;
+
+    SDL_UpdateTexture(presenter->texture, &rect, &presenter->pixels[RECT_ROWS * y_first + x_first], RECT_ROWS * sizeof(u32));
+    presenter->uploaded_texels += rect.w * rect.h;
+}
+
+// @Note: XORs the new mask against the last presented one, rows with nothing set in the
+// difference are skipped. Consecutive changed rows get merged into a single dirty rect
+// that covers their changed x ranges, only those get sent to the texture.
+internal void mask_presenter_update(Mask_Presenter *presenter, Coverage_Mask *mask)
+{
+    presenter->uploaded_texels = 0;
+    presenter->changed_cells = kernels->xor_popcount(mask->words, presenter->previous.words, presenter->diff.words, ARRAY_LEN(mask->words));
+    if (presenter->changed_cells == 0) return;
+    
+    s32 dirty_y_first = -1;
+    s32 dirty_x_first = 0;
+    s32 dirty_x_last = 0;
+    
+    for (s32 y = 0; y < RECT_COLS; ++y) {
+        u64 *diff = &presenter->diff.words[MASK_WORDS * y];
+        
+        s32 x_first = RECT_ROWS;
+        s32 x_last = -1;
+        
+        for (s32 w = 0; w < MASK_WORDS; ++w) {
+            if (diff[w] == 0) continue;
+            
+            x_first = MIN(x_first, w*64 + (s32) lowest_set_bit64(diff[w]));
+            x_last = MAX(x_last, w*64 + (s32) highest_set_bit64(diff[w]));
+        }
+
+        if (x_last == -1) {
+            if (dirty_y_first != -1) {
+                mask_presenter_upload(presenter, dirty_y_first, y - 1, dirty_x_first, dirty_x_last);
+                dirty_y_first = -1;
+            }
+            continue;
+        }
+
+        kernels->fill_texels(&mask->words[MASK_WORDS * y], x_first, x_last, &presenter->pixels[RECT_ROWS * y], presenter->color);
+
+        if (dirty_y_first == -1) {
+            dirty_y_first = y;
+            dirty_x_first = x_first;
+            dirty_x_last = x_last;
+        } else {
+            dirty_x_first = MIN(dirty_x_first, x_first);
+            dirty_x_last = MAX(dirty_x_last, x_last);
+        }
+    }
+
+    if (dirty_y_first != -1) {
+        mask_presenter_upload(presenter, dirty_y_first, RECT_COLS - 1, dirty_x_first, dirty_x_last);
+    }
+
+    memcpy(presenter->previous.words, mask->words, sizeof(mask->words));
+}
+
+internal void coverage_mask_clear_rows(Coverage_Mask *mask, s32 y_first, s32 y_last)
+{
+    memset(&mask->words[MASK_WORDS * y_first], 0, MASK_WORDS * (y_last - y_first) * sizeof(u64));
+}
+
+internal Span_Sink span_sink_grid(Raster_Grid *grid)
+{
+    Span_Sink sink = {};
+    sink.type = SPAN_SINK_GRID;
+    sink.grid = grid;
+
+    return(sink);
+}
+
+internal Span_Sink span_sink_mask(Coverage_Mask *mask)
+{
+    Span_Sink sink = {};
+    sink.type = SPAN_SINK_MASK;
+    sink.mask = mask;
+
+    return(sink);
+}
+
+internal Span_Sink span_sink_spans(Span_Array *spans)
+{
+    Span_Sink sink = {};
+    sink.type = SPAN_SINK_SPANS;
+    sink.spans = spans;
+
+    return(sink);
+}
+
+internal Span_Sink span_sink_rects(Rect_Batch *rects)
+{
+    Span_Sink sink = {};
+    sink.type = SPAN_SINK_RECTS;
+    sink.rects = rects;
+
+    return(sink);
+}
+
+internal Span_Sink span_sink_file(FILE *file)
+{
+    Span_Sink sink = {};
+    sink.type = SPAN_SINK_FILE;
+    sink.file = file;
+
+    return(sink);
+}
+
+internal void span_sink_begin(Span_Sink *sink)
+{
+    switch (sink->type) {
+        case SPAN_SINK_GRID: raster_grid_begin(sink->grid); break;
+        case SPAN_SINK_MASK: memset(sink->mask->words, 0, sizeof(sink->mask->words)); break;
+        case SPAN_SINK_SPANS: sink->spans->size = 0; break;
+        case SPAN_SINK_RECTS: sink->rects->size = 0; break;
+        case SPAN_SINK_FILE: fprintf(sink->file, "# y x0 x1 coverage\n"); break;
+        default: assert(false && "Unknown span sink");
+    }
+}
+
+internal inline bool span_sink_cancelled(Span_Sink *sink)
+{
+    return(sink->latest != 0 && SDL_AtomicGet(sink->latest) != sink->generation);
+}
+
+// @Note: Returns false when the engine should stop producing rows.
+internal bool span_sink_row(Span_Sink *sink, Span_Row *row)
+{
+    for (size_t i = 0; i < row->size; ++i) {
+        Span *span = &row->data[i];
+
+        switch (sink->type) {
+            case SPAN_SINK_GRID: {
+                for (s32 x = span->x0; x < span->x1; ++x) raster_grid_fill(sink->grid, x, span->y);
+            } break;
+
+            case SPAN_SINK_MASK: {
+                coverage_mask_fill(sink->mask, span->y, span->x0, span->x1);
+            } break;
+
+            case SPAN_SINK_SPANS: {
+                assert(sink->spans->size < SPANS_MAX);
+                sink->spans->data[sink->spans->size++] = *span;
+            } break;
+
+            case SPAN_SINK_RECTS: {
+                assert(sink->rects->size < SPANS_MAX);
+                
+                SDL_Rect rect = {0};
+                rect.x = span->x0 * RECT_RES;
+                rect.y = span->y * RECT_RES;
+                rect.w = (span->x1 - span->x0) * RECT_RES;
+                rect.h = RECT_RES;
+                sink->rects->data[sink->rects->size++] = rect;
+            } break;
+
+            case SPAN_SINK_FILE: {
+                fprintf(sink->file, "%d %d %d %u\n", span->y, span->x0, span->x1, span->coverage);
+            } break;
+            
+            default: assert(false && "Unknown span sink");
+        }
+    }
+
+    return(!span_sink_cancelled(sink));
+}
+
+internal void span_sink_end(Span_Sink *sink)
+{
+    if (sink->type == SPAN_SINK_FILE) fflush(sink->file);
+}
+
+// @ToDo: Add more fill rules to see how they work on different shapes.
+//
+// @Note: Every engine only produces the output rows (along y) in [y_first, y_last) and returns
+// false when the sink asked it to stop. Beginning and ending the sink is up to the caller,
+// this way a shape can be rasterized in several slices, see 'Incremental_Raster'. Whatever
+// they need for themselves comes from 'scratch' and is gone again once they return.
+internal bool rasterize_shape(Line_Array *lines, s32 y_first, s32 y_last, Span_Sink *sink, Arena *scratch)
+{
+    s32 min_x, max_x, min_y, max_y;
+    get_shape_bounds(lines, &min_x, &max_x, &min_y, &max_y);
+
+    s32 row_first, row_last, col_first, col_last;
+    get_sample_range(min_x, max_x, RECT_ROWS, &row_first, &row_last);
+    get_sample_range(min_y, max_y, RECT_COLS, &col_first, &col_last);
+    col_first = MAX(col_first, y_first);
+    col_last = MIN(col_last, y_last);
+
+    Arena_Temp temp = arena_begin_temp(scratch);
+    Span_Row *spans = ARENA_PUSH_STRUCT(scratch, Span_Row);
+    bool finished = true;
+    
+    for (s32 col = col_first; col < col_last && finished; ++col) {
+        spans->size = 0;
+        
+        for (s32 row = row_first; row < row_last; ++row) {
+            u32 intersections = 0;
+            for (size_t i = 0; i < lines->size; ++i) {
+                if (ray_hits_line(lines->data[i], cell_sample(row), cell_sample(col))) intersections += 1;
+            }
+
+            if (intersections % 2 != 0) span_row_push(spans, col, row, row + 1);
+        }
+
+        finished = span_sink_row(sink, spans);
+    }
+
+    arena_end_temp(temp);
+    return(finished);
+}
+
+// @Note: Marks every tile of 'band' (along y) the line passes through and returns whether the
+// line reaches into the band at all. We clip the line to the band and mark the x range it
+// covers. Tiles that are only touched on their border get marked as well, being conservative
+// here is fine, it only sends a tile to the fine rasterizer for nothing. The division below
+// rounds towards zero so the x range gets padded by one unit on both sides to stay conservative.
+internal bool bin_line(Tile_Bins *bins, s32 x0, s32 y0, s32 x1, s32 y1, u32 line_bit, s32 band)
+{
+    const s32 tile_span = FIXED_FROM_CELLS(TILE_SIZE);
+    
+    if (y0 > y1) {
+        s32 tmp = x0; x0 = x1; x1 = tmp;
+        tmp = y0; y0 = y1; y1 = tmp;
+    }
+
+    if (y1 < band * tile_span || y0 > (band + 1) * tile_span) return(false);
+    
+    s32 band_y0 = MAX(y0, band * tile_span);
+    s32 band_y1 = MIN(y1, (band + 1) * tile_span);
+
+    s32 bx0 = x0;
+    s32 bx1 = x1;
+    if (y1 != y0) {
+        bx0 = x0 + (s32) ((s64) (band_y0 - y0) * (x1 - x0) / (y1 - y0));
+        bx1 = x0 + (s32) ((s64) (band_y1 - y0) * (x1 - x0) / (y1 - y0));
+    }
+
+    s32 tile_first = (MIN(bx0, bx1) - 1) / tile_span;
+    s32 tile_last = (MAX(bx0, bx1) + 1) / tile_span;
+    tile_first = MAX(tile_first, 0);
+    tile_last = MIN(tile_last, TILE_ROWS - 1);
+
+    for (s32 tile = tile_first; tile <= tile_last; ++tile) {
+        bins->masks[tile] |= line_bit;
+    }
+
+    return(true);
+}
+
+// @Note: Only lines binned into the tile can change the parity between samples inside it,
+// every other line crossing a given sample row does so left or right of the whole tile.
+// This means we can resolve them once per row with the first sample and only run the
+// binned lines per cell. Works on the 'active' lines of the group, bit 'row - row_first'
+// of 'cells[col - col_first]' gets flipped for every cell the group crosses the ray of an
+// odd number of times.
+//
+// With no lines binned ('mask' is zero) every row of the tile is flipped as a whole, that's
+// how tiles get resolved when the group is only a part of the shape. The single corner
+// test only works for the whole shape, a part of it isn't closed and can still change the
+// parity between rows left of the tile.
+internal void rasterize_tile_fine(Line_Group *group, u32 active, u32 mask, s32 row_first, s32 row_last, s32 col_first, s32 col_last, u32 *cells)
+{
+    u32 full = (row_last - row_first == 32) ? 0xFFFFFFFFu : (1u << (row_last - row_first)) - 1;
+    
+    for (s32 col = col_first; col < col_last; ++col) {
+        s32 y = cell_sample(col);
+        u32 outside = popcount64(kernels->crossings(group, active & ~mask, cell_sample(row_first), y));
+
+        if (mask == 0) {
+            if (outside % 2 != 0) cells[col - col_first] ^= full;
+            continue;
+        }
+
+        for (s32 row = row_first; row < row_last; ++row) {
+            u32 intersections = outside + popcount64(kernels->crossings(group, mask, cell_sample(row), y));
+            if (intersections % 2 != 0) cells[col - col_first] ^= 1u << (row - row_first);
+        }
+    }
+}
+
+// @Note: Two level rasterizer, first bins lines into TILE_SIZE x TILE_SIZE tiles, then tiles
+// with no lines crossing them are either entirely inside or outside of the shape, so a single
+// ray test at the corner sample decides the whole tile. Only tiles with lines crossing
+// them go through the per-cell test. Should produce the same output as 'rasterize_shape'.
+//
+// We go one band of tiles (along y) at a time, first resolving every tile in the band and then
+// stitching the rows of the band together into spans. Inside a band the lines are handled
+// TILE_GROUP_LINES at a time, the parity of a sample is the sum of what every line contributes
+// so each group just flips the cells it crosses an odd number of times. Groups with no line
+// reaching into the band don't contribute anything and get skipped. Only a shape that fits in a
+// single group gets its uncrossed tiles decided by a single ray test, see 'rasterize_tile_fine'.
+//
+// The lines get packed into groups once up front, along with the y range each group covers,
+// so bands skip whole groups and bin straight out of them.
+internal bool rasterize_shape_tiled(Line_Array *lines, s32 y_first, s32 y_last, Span_Sink *sink, Arena *scratch)
+{
+    const s32 tile_span = FIXED_FROM_CELLS(TILE_SIZE);
+    
+    s32 min_x, max_x, min_y, max_y;
+    get_shape_bounds(lines, &min_x, &max_x, &min_y, &max_y);
+
+    s32 shape_row_first, shape_row_last, shape_col_first, shape_col_last;
+    get_sample_range(min_x, max_x, RECT_ROWS, &shape_row_first, &shape_row_last);
+    get_sample_range(min_y, max_y, RECT_COLS, &shape_col_first, &shape_col_last);
+    shape_col_first = MAX(shape_col_first, y_first);
+    shape_col_last = MIN(shape_col_last, y_last);
+    if (shape_row_first >= shape_row_last || shape_col_first >= shape_col_last) return(true);
+
+    s32 tile_row_first = shape_row_first / TILE_SIZE;
+    s32 tile_row_last = (shape_row_last - 1) / TILE_SIZE;
+    bool single_group = lines->size <= TILE_GROUP_LINES;
+
+    Arena_Temp temp = arena_begin_temp(scratch);
+    
+    size_t group_count = (lines->size + TILE_GROUP_LINES - 1) / TILE_GROUP_LINES;
+    Line_Group *groups = ARENA_PUSH_ARRAY(scratch, Line_Group, group_count);
+    s32 *group_min_y = ARENA_PUSH_ARRAY(scratch, s32, group_count);
+    s32 *group_max_y = ARENA_PUSH_ARRAY(scratch, s32, group_count);
+    
+    for (size_t i = 0; i < lines->size; ++i) {
+        size_t g = i / TILE_GROUP_LINES;
+        size_t lane = i % TILE_GROUP_LINES;
+        Line line = lines->data[i];
+        
+        groups[g].x0[lane] = line.x0;
+        groups[g].y0[lane] = line.y0;
+        groups[g].x1[lane] = line.x1;
+        groups[g].y1[lane] = line.y1;
+        
+        if (lane == 0) {
+            group_min_y[g] = MIN(line.y0, line.y1);
+            group_max_y[g] = MAX(line.y0, line.y1);
+        } else {
+            group_min_y[g] = MIN(group_min_y[g], MIN(line.y0, line.y1));
+            group_max_y[g] = MAX(group_max_y[g], MAX(line.y0, line.y1));
+        }
+    }
+
+    // @Note: Whole tiles that are inside get all of their bits set, outside ones stay zero.
+    u32 (*cells)[TILE_SIZE] = (u32 (*)[TILE_SIZE]) arena_push(scratch, sizeof(u32) * TILE_ROWS * TILE_SIZE);
+    Span_Row *spans = ARENA_PUSH_STRUCT(scratch, Span_Row);
+    bool finished = true;
+    
+    for (s32 tile_col = shape_col_first / TILE_SIZE; tile_col <= (shape_col_last - 1) / TILE_SIZE && finished; ++tile_col) {
+        s32 col_first = MAX(tile_col * TILE_SIZE, shape_col_first);
+        s32 col_last = MIN((tile_col + 1) * TILE_SIZE, shape_col_last);
+
+        memset(cells, 0, sizeof(u32) * TILE_ROWS * TILE_SIZE);
+
+        for (size_t g = 0; g < group_count; ++g) {
+            if (group_max_y[g] < tile_col * tile_span || group_min_y[g] > (tile_col + 1) * tile_span) continue;
+            
+            Line_Group *group = &groups[g];
+            u32 count = (u32) MIN(lines->size - g * TILE_GROUP_LINES, TILE_GROUP_LINES);
+            
+            Tile_Bins bins = {0};
+            u32 active = 0;
+            for (u32 i = 0; i < count; ++i) {
+                if (bin_line(&bins, group->x0[i], group->y0[i], group->x1[i], group->y1[i], 1u << i, tile_col)) active |= 1u << i;
+            }
+            if (active == 0) continue;
+        
+            for (s32 tile_row = tile_row_first; tile_row <= tile_row_last; ++tile_row) {
+                s32 row_first = MAX(tile_row * TILE_SIZE, shape_row_first);
+                s32 row_last = MIN((tile_row + 1) * TILE_SIZE, shape_row_last);
+
+                u32 mask = bins.masks[tile_row];
+                if (mask != 0 || !single_group) {
+                    rasterize_tile_fine(group, active, mask, row_first, row_last, col_first, col_last, cells[tile_row]);
+                    continue;
+                }
+
+                u32 intersections = popcount64(kernels->crossings(group, active, cell_sample(row_first), cell_sample(col_first)));
+                if (intersections % 2 == 0) continue;
+
+                u32 full = (row_last - row_first == 32) ? 0xFFFFFFFFu : (1u << (row_last - row_first)) - 1;
+                for (s32 col = col_first; col < col_last; ++col) cells[tile_row][col - col_first] ^= full;
+            }
+
+            if (span_sink_cancelled(sink)) {
+                finished = false;
+                break;
+            }
+        }
+
+        for (s32 col = col_first; col < col_last && finished; ++col) {
+            spans->size = 0;
+
+            for (s32 tile_row = tile_row_first; tile_row <= tile_row_last; ++tile_row) {
+                s32 row_first = MAX(tile_row * TILE_SIZE, shape_row_first);
+                u32 bits = cells[tile_row][col - col_first];
+
+                // @Note: Pull out runs of set bits, a whole filled tile is a single run.
+                while (bits) {
+                    s32 start = 0;
+                    while (!(bits & (1u << start))) start += 1;
+
+                    s32 end = start;
+                    while (end < 32 && (bits & (1u << end))) end += 1;
+
+                    span_row_push(spans, col, row_first + start, row_first + end);
+                    bits = (end == 32) ? 0 : bits & ~((1u << end) - 1);
+                }
+            }
+
+            finished = span_sink_row(sink, spans);
+        }
+    }
+
+    arena_end_temp(temp);
+    return(finished);
+}
+
+// @Note: Low resolution preview, one sample in the middle of every 'factor' x 'factor' block
+// of cells decides the whole block. Doesn't have to match the other engines, it only
+// gets shown until the full resolution result replaces it.
+internal bool rasterize_shape_coarse(Line_Array *lines, s32 factor, s32 y_first, s32 y_last, Span_Sink *sink, Arena *scratch)
+{
+    const s32 block_span = FIXED_FROM_CELLS(factor);
+    
+    s32 min_x, max_x, min_y, max_y;
+    get_shape_bounds(lines, &min_x, &max_x, &min_y, &max_y);
+
+    s32 block_x_first = MAX(min_x / block_span, 0);
+    s32 block_x_last = MIN(max_x / block_span, (RECT_ROWS - 1) / factor);
+    y_first = MAX(y_first, (min_y / block_span) * factor);
+    y_last = MIN(y_last, (max_y / block_span + 1) * factor);
+
+    Arena_Temp temp = arena_begin_temp(scratch);
+    Span_Row *spans = ARENA_PUSH_STRUCT(scratch, Span_Row);
+    bool finished = true;
+    
+    s32 y = y_first;
+    while (y < y_last && finished) {
+        s32 block_y = y / factor;
+        s32 block_y_last = MIN((block_y + 1) * factor, y_last);
+        s32 sample_y = block_y * block_span + block_span / 2;
+
+        spans->size = 0;
+
+        for (s32 block_x = block_x_first; block_x <= block_x_last; ++block_x) {
+            s32 sample_x = block_x * block_span + block_span / 2;
+            
+            u32 intersections = 0;
+            for (size_t i = 0; i < lines->size; ++i) {
+                if (ray_hits_line_fixed(lines->data[i], sample_x, sample_y)) intersections += 1;
+            }
+
+            if (intersections % 2 != 0) span_row_push(spans, y, block_x * factor, MIN((block_x + 1) * factor, RECT_ROWS));
+        }
+
+        // @Note: Every row of the block gets the same spans.
+        for (; y < block_y_last && finished; ++y) {
+            for (size_t i = 0; i < spans->size; ++i) spans->data[i].y = y;
+            finished = span_sink_row(sink, spans);
+        }
+    }
+
+    arena_end_temp(temp);
+    return(finished);
+}
+
+#define AUTO_DECAY 0.95
+#define AUTO_MIN_SAMPLES 4.0
+#define AUTO_EXPLORE_INTERVAL 16
+#define AUTO_EXPLORE_MARGIN 2.0
+
+// @Note: Starting points measured on the default and generated scenes, in ns.
+global const f64 auto_prior_intercept[RASTER_ENGINE_AUTO] = {500.0, 2000.0};
+global const f64 auto_prior_slope[RASTER_ENGINE_AUTO] = {1.5, 10.0};
+
+internal Shape_Features shape_features(Line_Array *lines, s32 y_first, s32 y_last)
+{
+    Shape_Features features = {};
+    
+    s32 min_x, max_x, min_y, max_y;
+    get_shape_bounds(lines, &min_x, &max_x, &min_y, &max_y);
+
+    s32 row_first, row_last, col_first, col_last;
+    get_sample_range(min_x, max_x, RECT_ROWS, &row_first, &row_last);
+    get_sample_range(min_y, max_y, RECT_COLS, &col_first, &col_last);
+    col_first = MAX(col_first, y_first);
+    col_last = MIN(col_last, y_last);
+    if (row_first >= row_last || col_first >= col_last) return(features);
+
+    features.edges = (f64) lines->size;
+    features.cells = (f64) (row_last - row_first) * (col_last - col_first);
+    features.bands = (f64) ((col_last - 1) / TILE_SIZE - col_first / TILE_SIZE + 1);
+
+    // @Note: Manhattan length is plenty for a cost estimate.
+    s64 perimeter = 0;
+    for (size_t i = 0; i < lines->size; ++i) {
+        perimeter += abs(lines->data[i].x1 - lines->data[i].x0) + abs(lines->data[i].y1 - lines->data[i].y0);
+    }
+    features.perimeter = (f64) perimeter / FIXED_ONE;
+    
+    return(features);
+}
+
+// @Note: Rough count of the inner loop iterations each engine goes through. The reference
+// tests every line against every sample. The tiled engine bins every line once per band, runs
+// the per-cell test along the outline (a strip about TILE_SIZE wide) and, with more than one
+// group, flips every uncrossed tile row by row once per group.
+internal f64 engine_work(Raster_Engine engine, Shape_Features *features)
+{
+    switch (engine) {
+        case RASTER_ENGINE_REFERENCE: return(features->cells * features->edges);
+        case RASTER_ENGINE_TILED: {
+            f64 groups = ceil(features->edges / TILE_GROUP_LINES);
+            f64 uncrossed = groups > 1 ? features->cells / TILE_SIZE * groups : features->cells / (TILE_SIZE * TILE_SIZE);
+            return(features->edges * features->bands + features->perimeter * TILE_SIZE + uncrossed);
+        }
+        default: assert(false && "Not an engine auto can pick");
+    }
+
+    return(0);
+}
+
+internal f64 engine_fit_predict(Engine_Fit *fit, Raster_Engine engine, f64 work)
+{
+    if (fit->n < AUTO_MIN_SAMPLES) return(auto_prior_intercept[engine] + auto_prior_slope[engine] * work);
+    return(fit->intercept + fit->slope * work);
+}
+
+// @Note: With every sample close to the same amount of work (say while dragging a vertex) there's
+// nothing to fit a line through, then it goes through the origin instead.
+internal void engine_fit_add(Engine_Fit *fit, f64 work, f64 ns)
+{
+    fit->n = fit->n * AUTO_DECAY + 1.0;
+    fit->sum_w = fit->sum_w * AUTO_DECAY + work;
+    fit->sum_t = fit->sum_t * AUTO_DECAY + ns;
+    fit->sum_ww = fit->sum_ww * AUTO_DECAY + work * work;
+    fit->sum_wt = fit->sum_wt * AUTO_DECAY + work * ns;
+
+    f64 variance = fit->n * fit->sum_ww - fit->sum_w * fit->sum_w;
+    f64 slope = variance > 1e-6 * fit->n * fit->sum_ww ? (fit->n * fit->sum_wt - fit->sum_w * fit->sum_t) / variance : 0.0;
+    f64 intercept = (fit->sum_t - slope * fit->sum_w) / fit->n;
+    
+    if (slope <= 0.0 || intercept < 0.0) {
+        slope = fit->sum_ww > 0.0 ? fit->sum_wt / fit->sum_ww : 0.0;
+        intercept = 0.0;
+    }
+
+    fit->slope = slope;
+    fit->intercept = intercept;
+}
+
+// @Note: Picks the engine the model thinks is cheapest and feeds the time it actually took back
+// into that engine's fit. Every AUTO_EXPLORE_INTERVAL-th decision goes to the other engine so
+// the fit of the one that's losing still gets samples, as long as it's predicted within
+// AUTO_EXPLORE_MARGIN of the best. Both produce the same coverage so nobody sees a difference.
+internal bool rasterize_shape_auto(Line_Array *lines, s32 y_first, s32 y_last, Span_Sink *sink, Arena *scratch)
+{
+    Shape_Features features = shape_features(lines, y_first, y_last);
+    if (features.cells == 0) return(rasterize_shape(lines, y_first, y_last, sink, scratch));
+
+    f64 work[RASTER_ENGINE_AUTO];
+    f64 predicted[RASTER_ENGINE_AUTO];
+    
+    SDL_AtomicLock(&auto_engine.lock);
+    s32 best = 0;
+    for (s32 engine = 0; engine < RASTER_ENGINE_AUTO; ++engine) {
+        work[engine] = engine_work((Raster_Engine) engine, &features);
+        predicted[engine] = engine_fit_predict(&auto_engine.fits[engine], (Raster_Engine) engine, work[engine]);
+        if (predicted[engine] < predicted[best]) best = engine;
+    }
+    
+    auto_engine.decisions += 1;
+    s32 other = (best + 1) % RASTER_ENGINE_AUTO;
+    if (auto_engine.decisions % AUTO_EXPLORE_INTERVAL == 0 && predicted[other] < AUTO_EXPLORE_MARGIN * predicted[best]) best = other;
+    SDL_AtomicUnlock(&auto_engine.lock);
+
+    Raster_Engine engine = (Raster_Engine) best;
+    u64 start = SDL_GetPerformanceCounter();
+    bool finished = (engine == RASTER_ENGINE_REFERENCE) ?
+        rasterize_shape(lines, y_first, y_last, sink, scratch) :
+        rasterize_shape_tiled(lines, y_first, y_last, sink, scratch);
+    u64 end = SDL_GetPerformanceCounter();
+    
+    // @Note: A cancelled job stopped somewhere in the middle, its time says nothing.
+    if (!finished) return(false);
+
+    f64 ns = (f64) (end - start) * 1e9 / (f64) SDL_GetPerformanceFrequency();
+    
+    SDL_AtomicLock(&auto_engine.lock);
+    engine_fit_add(&auto_engine.fits[engine], work[engine], ns);
+    auto_engine.chosen[engine] += 1;
+    auto_engine.error_total += fabs(predicted[engine] - ns) / MAX(ns, 1.0);
+    auto_engine.measured += 1;
+    auto_engine.last_engine = engine;
+    auto_engine.last_predicted_ms = (f32) (predicted[engine] / 1e6);
+    auto_engine.last_actual_ms = (f32) (ns / 1e6);
+    SDL_AtomicUnlock(&auto_engine.lock);
+
+    return(true);
+}
+
+internal void auto_engine_report(void)
+{
+    SDL_AtomicLock(&auto_engine.lock);
+    if (auto_engine.measured > 0) {
+        printf("[INFO]: Auto engine made %u decisions, predictions off by %.1f%% on average\n",
+               auto_engine.measured, 100.0 * auto_engine.error_total / auto_engine.measured);
+        
+        for (s32 engine = 0; engine < RASTER_ENGINE_AUTO; ++engine) {
+            Engine_Fit *fit = &auto_engine.fits[engine];
+            printf("[INFO]:   %-10s picked %u times, %.1f ns + %.3f ns per unit of work%s\n", raster_engine_names[engine], auto_engine.chosen[engine],
+                   fit->n < AUTO_MIN_SAMPLES ? auto_prior_intercept[engine] : fit->intercept,
+                   fit->n < AUTO_MIN_SAMPLES ? auto_prior_slope[engine] : fit->slope,
+                   fit->n < AUTO_MIN_SAMPLES ? " (prior)" : "");
+        }
+    }
+    SDL_AtomicUnlock(&auto_engine.lock);
+}
+
+// @Note: 'coarse' greater than one asks for the low resolution preview instead of 'engine'.
+// @Note: An empty shape covers nothing, the engines all start from the first line's bounds.
+internal bool rasterize_rows(Raster_Engine engine, Line_Array *lines, s32 coarse, s32 y_first, s32 y_last, Span_Sink *sink, Arena *scratch)
+{
+    if (lines->size == 0) return(true);
+    if (coarse > 1) return(rasterize_shape_coarse(lines, coarse, y_first, y_last, sink, scratch));
+    
+    switch (engine) {
+        case RASTER_ENGINE_REFERENCE: return(rasterize_shape(lines, y_first, y_last, sink, scratch));
+        case RASTER_ENGINE_TILED: return(rasterize_shape_tiled(lines, y_first, y_last, sink, scratch));
+        case RASTER_ENGINE_AUTO: return(rasterize_shape_auto(lines, y_first, y_last, sink, scratch));
+        default: assert(false && "Unknown raster engine");
+    }
+
+    return(false);
+}
+
+internal void rasterize(Raster_Engine engine, Line_Array *lines, s32 coarse, Span_Sink *sink, Arena *scratch)
+{
+    span_sink_begin(sink);
+    rasterize_rows(engine, lines, coarse, 0, RECT_COLS, sink, scratch);
+    span_sink_end(sink);
+}
+
+internal void triple_buffer_init(Triple_Buffer *buffer)
+{
+    buffer->back = 0;
+    SDL_AtomicSet(&buffer->middle, 1);
+    buffer->front = 2;
+}
+
+internal void triple_buffer_publish(Triple_Buffer *buffer)
+{
+    SDL_MemoryBarrierRelease();
+    buffer->back = SDL_AtomicSet(&buffer->middle, buffer->back | TRIPLE_BUFFER_FRESH) & TRIPLE_BUFFER_INDEX;
+}
+
+// @Note: Returns false if nothing new was published since the last acquire.
+internal bool triple_buffer_acquire(Triple_Buffer *buffer)
+{
+    if (!(SDL_AtomicGet(&buffer->middle) & TRIPLE_BUFFER_FRESH)) return(false);
+
+    buffer->front = SDL_AtomicSet(&buffer->middle, buffer->front) & TRIPLE_BUFFER_INDEX;
+    SDL_MemoryBarrierAcquire();
+
+    return(true);
+}
+
+internal int raster_worker_thread(void *data)
+{
+    Raster_Worker *worker = (Raster_Worker *) data;
+    alloc_phase = ALLOC_PHASE_WORKER;
+
+    while (!SDL_AtomicGet(&worker->quit)) {
+        SDL_SemWait(worker->wakeup);
+        if (!triple_buffer_acquire(&worker->job_buffer)) continue;
+
+        Raster_Job *job = &worker->jobs[worker->job_buffer.front];
+        Raster_Result *result = &worker->results[worker->result_buffer.back];
+        arena_reset(&worker->arena);
+        
+        Span_Sink sink = span_sink_mask(&result->mask);
+        sink.latest = &worker->latest_generation;
+        sink.generation = job->generation;
+
+        u64 start = SDL_GetPerformanceCounter();
+        rasterize(job->engine, &job->lines, job->coarse, &sink, &worker->arena);
+        u64 end = SDL_GetPerformanceCounter();
+
+        // @Note: A newer job is already waiting, nobody wants this one anymore.
+        if (span_sink_cancelled(&sink)) continue;
+
+        result->generation = job->generation;
+        result->coarse = job->coarse;
+        result->elapsed_ms = (f32) ((end - start) * 1000.0 / SDL_GetPerformanceFrequency());
+        triple_buffer_publish(&worker->result_buffer);
+    }
+
+    return(0);
+}
+
+internal void raster_worker_start(Raster_Worker *worker)
+{
+    triple_buffer_init(&worker->job_buffer);
+    triple_buffer_init(&worker->result_buffer);
+    SDL_AtomicSet(&worker->quit, 0);
+    SDL_AtomicSet(&worker->latest_generation, 0);
+    worker->submitted = 0;
+    worker->arena = {};
+    worker->arena.name = "worker";
+
+    worker->wakeup = SDL_CreateSemaphore(0);
+    ERROR_EXIT(worker->wakeup == 0, "[ERROR]: Could not create semaphore -> %s\n", SDL_GetError());
+    
+    worker->thread = SDL_CreateThread(raster_worker_thread, "raster_worker", worker);
+    ERROR_EXIT(worker->thread == 0, "[ERROR]: Could not create raster worker -> %s\n", SDL_GetError());
+}
+
+internal void raster_worker_stop(Raster_Worker *worker)
+{
+    SDL_AtomicSet(&worker->quit, 1);
+    SDL_SemPost(worker->wakeup);
+    SDL_WaitThread(worker->thread, 0);
+    SDL_DestroySemaphore(worker->wakeup);
+
+    for (size_t i = 0; i < ARRAY_LEN(worker->jobs); ++i) line_array_free(&worker->jobs[i].lines);
+    arena_free(&worker->arena);
+}
+
+// @Note: Called from the UI thread only, never blocks.
+internal void raster_worker_submit(Raster_Worker *worker, Line_Array *lines, Raster_Engine engine, s32 coarse)
+{
+    Raster_Job *job = &worker->jobs[worker->job_buffer.back];
+    line_array_copy(&job->lines, lines);
+    job->engine = engine;
+    job->coarse = coarse;
+    job->generation = ++worker->submitted;
+
+    SDL_AtomicSet(&worker->latest_generation, job->generation);
+    triple_buffer_publish(&worker->job_buffer);
+    SDL_SemPost(worker->wakeup);
+}
+
+// @Note: Called from the UI thread only, returns the newest completed result.
+internal Raster_Result *raster_worker_latest(Raster_Worker *worker)
+{
+    triple_buffer_acquire(&worker->result_buffer);
+    return(&worker->results[worker->result_buffer.front]);
+}
+
+// @Note: Restarts from the top with a fresh snapshot, whatever the previous job didn't
+// get to yet is simply dropped.
+internal void incremental_raster_start(Incremental_Raster *incremental, Line_Array *lines, Raster_Engine engine, s32 coarse)
+{
+    line_array_copy(&incremental->lines, lines);
+    incremental->engine = engine;
+    incremental->coarse = coarse;
+    incremental->next_y = 0;
+    incremental->running = true;
+}
+
+internal void incremental_raster_step(Incremental_Raster *incremental, u32 budget_ms)
+{
+    if (!incremental->running) return;
+
+    u64 start = SDL_GetPerformanceCounter();
+    u64 budget = SDL_GetPerformanceFrequency() * budget_ms / 1000;
+    
+    Span_Sink sink = span_sink_mask(&incremental->mask);
+    
+    do {
+        s32 y_first = incremental->next_y;
+        s32 y_last = MIN(y_first + TILE_SIZE, RECT_COLS);
+
+        // @Note: We're not beginning the sink on purpose, it would clear the whole mask.
+        coverage_mask_clear_rows(&incremental->mask, y_first, y_last);
+        rasterize_rows(incremental->engine, &incremental->lines, incremental->coarse, y_first, y_last, &sink, &frame_arena);
+        incremental->next_y = y_last;
+    } while (incremental->next_y < RECT_COLS && SDL_GetPerformanceCounter() - start < budget);
+
+    if (incremental->next_y == RECT_COLS) incremental->running = false;
+}
+
+internal void raster_ctx_submit(Raster_Ctx *ctx, Line_Array *lines, s32 coarse)
+{
+    switch (ctx->mode) {
+        case RASTER_MODE_WORKER: raster_worker_submit(&ctx->worker, lines, ctx->engine, coarse); break;
+        case RASTER_MODE_INCREMENTAL: incremental_raster_start(&ctx->incremental, lines, ctx->engine, coarse); break;
+        default: assert(false && "Unknown raster mode");
+    }
+}
+
+internal void raster_ctx_request(Raster_Ctx *ctx, Line_Array *lines)
+{
+    ctx->preview_pending = false;
+    raster_ctx_submit(ctx, lines, 1);
+}
+
+// @Note: Used while the user drags, the preview gets refined in 'raster_ctx_update'.
+internal void raster_ctx_request_preview(Raster_Ctx *ctx, Line_Array *lines)
+{
+    if (ctx->preview_factor <= 1) {
+        raster_ctx_request(ctx, lines);
+        return;
+    }
+
+    ctx->preview_pending = true;
+    ctx->last_preview_ticks = ctx->now;
+    raster_ctx_submit(ctx, lines, ctx->preview_factor);
+}
+
+// @Note: Called once per frame, refines the drag preview when it's time and
+// advances the incremental job.
+internal void raster_ctx_update(Raster_Ctx *ctx, Line_Array *lines, bool dragging)
+{
+    if (ctx->preview_pending && (!dragging || ctx->now - ctx->last_preview_ticks >= PREVIEW_IDLE_MS)) {
+        raster_ctx_request(ctx, lines);
+    }
+    
+    if (ctx->mode == RASTER_MODE_INCREMENTAL) {
+        u64 start = SDL_GetPerformanceCounter();
+        incremental_raster_step(&ctx->incremental, INCREMENTAL_BUDGET_MS);
+        u64 end = SDL_GetPerformanceCounter();
+
+        ctx->shown_elapsed_ms = (f32) ((end - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    }
+}
+
+// @Note: Blocks until whatever was requested so far is on its way to the screen, the
+// interactive loop never does this, replays do so each frame shows a known state.
+internal void raster_ctx_finish(Raster_Ctx *ctx)
+{
+    if (ctx->mode == RASTER_MODE_INCREMENTAL) {
+        while (ctx->incremental.running) incremental_raster_step(&ctx->incremental, INCREMENTAL_BUDGET_MS);
+        return;
+    }
+
+    while (raster_worker_latest(&ctx->worker)->generation != ctx->worker.submitted) SDL_Delay(0);
+}
+
+// @Note: Gives back the mask that should be on screen.
+internal Coverage_Mask *raster_ctx_shown(Raster_Ctx *ctx)
+{
+    if (ctx->mode == RASTER_MODE_INCREMENTAL) {
+        ctx->shown_coarse = ctx->incremental.coarse;
+        return(&ctx->incremental.mask);
+    }
+
+    Raster_Result *result = raster_worker_latest(&ctx->worker);
+    ctx->shown_coarse = result->coarse;
+    ctx->shown_elapsed_ms = result->elapsed_ms;
+    return(&result->mask);
+}
+
+internal void report_stats(Render_Ctx *render, Raster_Ctx *ctx, Mask_Presenter *presenter, Alloc_Frame *allocs)
+{
+    char title[384];
+    char preview[32];
+    char engine[96];
+
+    if (ctx->preview_factor > 1) snprintf(preview, sizeof(preview), "%dx%d", ctx->preview_factor, ctx->preview_factor);
+    else snprintf(preview, sizeof(preview), "off");
+
+    if (ctx->engine == RASTER_ENGINE_AUTO) {
+        SDL_AtomicLock(&auto_engine.lock);
+        snprintf(engine, sizeof(engine), "auto: %s, predicted %.3f ms, took %.3f ms", raster_engine_names[auto_engine.last_engine],
+                 auto_engine.last_predicted_ms, auto_engine.last_actual_ms);
+        SDL_AtomicUnlock(&auto_engine.lock);
+    } else {
+        snprintf(engine, sizeof(engine), "%s", raster_engine_names[ctx->engine]);
+    }
+
+    snprintf(title, sizeof(title), "A Window | %s, %s | preview: %s | shown: %s | raster: %.3f ms | uploaded: %u texels | allocs: %llu (%llu B) | peak: %llu B | arena: %zu B",
+             engine, raster_mode_names[ctx->mode], preview,
+             ctx->shown_coarse > 1 ? "coarse" : "full", ctx->shown_elapsed_ms, presenter->uploaded_texels,
+             (unsigned long long) allocs->total.allocations, (unsigned long long) allocs->total.bytes, (unsigned long long) allocs->total.peak, frame_arena.high_water);
+    
+    SDL_SetWindowTitle(render->window, title);
+}
+
+internal s32 get_index_of_selected_origin(s32 mouse_x, s32 mouse_y, Line_Array *lines)
+{
+    const s32 w = 2*CIRCLE_RADIUS;
+    
+    for (s32 i = 0; i < (s32) lines->size; ++i) {
+        s32 x = fixed_to_screen(lines->data[i].x0) - CIRCLE_RADIUS;
+        s32 y = fixed_to_screen(lines->data[i].y0) - CIRCLE_RADIUS;
+        
+        if ((mouse_x >= x && mouse_x <= x + w) &&
+            (mouse_y >= y && mouse_y <= y + w))
+        {
+            return(i);
+        }
+    }
+
+    return(-1);
+}
+
+internal void add_new_point(s32 mouse_x, s32 mouse_y, Line_Array *lines)
+{
+    assert(lines->size >= 3);
+
+    s32 x0 = screen_to_fixed(mouse_x);
+    s32 y0 = screen_to_fixed(mouse_y);
+    s32 x1 = lines->data[0].x0;
+    s32 y1 = lines->data[0].y0;
+    
+    s64 min_dist = sqr_distance(x0, y0, x1, y1); 
+    size_t index = 0;
+    
+    for (size_t i = 1; i < lines->size; ++i) {
+        x1 = lines->data[i].x0;
+        y1 = lines->data[i].y0;
+        s64 dist = sqr_distance(x0, y0, x1, y1);
+
+        if (dist < min_dist) {
+            index = i;
+            min_dist = dist;
+        }
+    }
+
+    // @Note: Find closest line between next and prev.
+    size_t next = lines->data[index].next;
+    size_t prev = lines->data[index].prev;
+    s64 dist_next = sqr_distance(x0, y0, lines->data[next].x0, lines->data[next].y0);
+    s64 dist_prev = sqr_distance(x0, y0, lines->data[prev].x0, lines->data[prev].y0);
+    
+    if (dist_next <= dist_prev) {
+        line_array_add(lines, x0, y0, lines->data[next].x0, lines->data[next].y0);
+        line_array_connect(lines, lines->size - 1, next, index);
+        line_array_reconnect(lines, index, lines->size - 1, next, x0, y0);
+    } else {
+        line_array_add(lines, x0, y0, lines->data[index].x0, lines->data[index].y0);
+        line_array_connect(lines, lines->size - 1, index, prev);
+        line_array_reconnect(lines, prev, lines->size - 1, index, x0, y0);
+    }
+}
+
+// @ToDo: lines->size and indexing is done through size_t, but
+// we're using signed 32 bit integer here and for line_index. Consider
+// using a pair or something? (C++ still won't allow to return multiple values...)
+internal void delete_point(s32 index, Line_Array *lines)
+{
+    if (lines->size == 3) return;
+
+    size_t selected_prev = lines->data[index].prev;
+    size_t selected_next = lines->data[index].next;
+    
+    lines->data[selected_prev].next = selected_next;
+    lines->data[selected_next].prev = selected_prev;
+    lines->data[selected_prev].x1 = lines->data[selected_next].x0;
+    lines->data[selected_prev].y1 = lines->data[selected_next].y0;
+
+    if ((size_t) index != lines->size - 1) {
+        size_t last = lines->size - 1;
+        size_t last_prev = lines->data[last].prev;
+        size_t last_next = lines->data[last].next;
+        
+        lines->data[last_prev].next = index;
+        lines->data[last_next].prev = index;
+        lines->data[index] = lines->data[last]; 
+    }
+    
+    lines->size -= 1;
+}
+
+internal void render_draw_circle(SDL_Renderer *renderer, u32 cx, u32 cy, u32 r)
+{
+    u32 x = r;
+    u32 y = 0;
+    s32 p = 1 - r;
+    
+    SDL_RenderDrawLine(renderer, cx-r, cy, cx+r, cy);
+    
+    while (x >= y) {
+        y += 1;
+        
+        if (p <= 0) {
+            p += 2*y + 1;
+        } else {
+            x -= 1;
+            p += 2*y - 2*x + 1;
+        }
+
+        SDL_RenderDrawLine(renderer, cx+x, cy-y, cx-x, cy-y);
+        SDL_RenderDrawLine(renderer, cx+x, cy+y, cx-x, cy+y);
+        SDL_RenderDrawLine(renderer, cx+y, cy-x, cx-y, cy-x);
+        SDL_RenderDrawLine(renderer, cx+y, cy+x, cx-y, cy+x);
+    }
+}
+
+internal Render_Ctx create_render_context(u32 width, u32 height, const char *window_title)
+{
+    Render_Ctx context = {0};
+
+    ERROR_EXIT(SDL_Init(SDL_INIT_VIDEO) != 0, "[ERROR]: Could not initialize SDL2 -> %s\n", SDL_GetError());
+
+    context.window = SDL_CreateWindow(window_title,
+                                      SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                      width, height,
+                                      SDL_WINDOW_SHOWN);
+    ERROR_EXIT(context.window == 0, "[ERROR]: Could not create SDL2 window");
+
+    context.renderer = SDL_CreateRenderer(context.window, -1, SDL_RENDERER_ACCELERATED);
+    // @Note: Headless runs (SDL_VIDEODRIVER=dummy) only get the software renderer.
+    if (context.renderer == 0) context.renderer = SDL_CreateRenderer(context.window, -1, SDL_RENDERER_SOFTWARE);
+    ERROR_EXIT(context.renderer == 0, "[ERROR]: Could not create SDL2 renderer");
+
+    SDL_SetHint(SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH, "1");
+    
+    return(context);
+}
+
+internal void destroy_render_context(Render_Ctx *ctx)
+{
+    SDL_DestroyWindow(ctx->window);
+    SDL_DestroyRenderer(ctx->renderer);
+
+    SDL_Quit();
+}
+
+internal void write_u32_le(u8 *out, u32 value)
+{
+    out[0] = (u8) (value);
+    out[1] = (u8) (value >> 8);
+    out[2] = (u8) (value >> 16);
+    out[3] = (u8) (value >> 24);
+}
+
+internal void write_u32_be(u8 *out, u32 value)
+{
+    out[0] = (u8) (value >> 24);
+    out[1] = (u8) (value >> 16);
+    out[2] = (u8) (value >> 8);
+    out[3] = (u8) (value);
+}
+
+internal u32 read_u32_le(u8 *in)
+{
+    return((u32) in[0] | ((u32) in[1] << 8) | ((u32) in[2] << 16) | ((u32) in[3] << 24));
+}
+
+// @Note: Small xorshift generator, the same seed gives the same numbers on every platform.
+struct Random_Series {
+    u64 state;
+};
+
+internal Random_Series random_seed(u64 seed)
+{
+    Random_Series series = {};
+    series.state = seed ^ 0x9E3779B97F4A7C15ull;
+    if (series.state == 0) series.state = 1;
+
+    return(series);
+}
+
+internal u32 random_next(Random_Series *series)
+{
+    u64 x = series->state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    series->state = x;
+
+    return((u32) (x >> 32));
+}
+
+// @Note: Inclusive on both ends.
+internal s32 random_range(Random_Series *series, s32 min, s32 max)
+{
+    return(min + (s32) (random_next(series) % (u32) (max - min + 1)));
+}
+
+// @Note: In [0, 1).
+internal f32 random_unit(Random_Series *series)
+{
+    return((f32) (random_next(series) >> 8) * (1.0f / 16777216.0f));
+}
+
+// @Note: Appends the closed path 'xs[0] -> xs[1] -> ... -> xs[0]' (fixed point) as a new loop.
+internal void line_array_add_contour(Line_Array *lines, s32 *xs, s32 *ys, size_t count)
+{
+    assert(count >= 3);
+    size_t base = lines->size;
+    line_array_reserve(lines, base + count);
+    
+    for (size_t i = 0; i < count; ++i) {
+        size_t next = (i + 1) % count;
+        line_array_add(lines, xs[i], ys[i], xs[next], ys[next]);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        line_array_connect(lines, base + i, base + (i + 1) % count, base + (i + count - 1) % count);
+    }
+}
+
+// @Note: Text file with one 'contour <count>' line per closed path followed by its
+// vertices, one 'x y' pair (24.8 fixed point) per line.
+internal void line_array_write_contours(Line_Array *lines, FILE *file)
+{
+    fprintf(file, "# contours, vertices in 24.8 fixed point\n");
+
+    u8 *visited = (u8 *) SDL_calloc(lines->size, 1);
+    ERROR_EXIT(lines->size > 0 && visited == 0, "[ERROR]: Out of memory for %zu lines\n", lines->size);
+    
+    for (size_t start = 0; start < lines->size; ++start) {
+        if (visited[start]) continue;
+
+        size_t count = 0;
+        size_t i = start;
+        do {
+            visited[i] = 1;
+            count += 1;
+            i = lines->data[i].next;
+        } while (i != start);
+
+        fprintf(file, "contour %zu\n", count);
+        do {
+            fprintf(file, "%d %d\n", lines->data[i].x0, lines->data[i].y0);
+            i = lines->data[i].next;
+        } while (i != start);
+    }
+
+    SDL_free(visited);
+}
+
+// @Note: Replaces whatever 'lines' held, returns false on a malformed file.
+internal bool line_array_read_contours(Line_Array *lines, FILE *file)
+{
+    char line[256];
+    s32 *xs = 0;
+    s32 *ys = 0;
+    size_t count = 0;
+    size_t expected = 0;
+    bool valid = true;
+
+    lines->size = 0;
+    
+    while (valid && fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        unsigned long long size;
+        s32 x, y;
+        if (sscanf(line, "contour %llu", &size) == 1) {
+            if (count != expected || size < 3) {
+                valid = false;
+                break;
+            }
+            
+            if (count > 0) line_array_add_contour(lines, xs, ys, count);
+            count = 0;
+            expected = (size_t) size;
+            
+            SDL_free(xs);
+            SDL_free(ys);
+            xs = (s32 *) SDL_malloc(expected * sizeof(s32));
+            ys = (s32 *) SDL_malloc(expected * sizeof(s32));
+            ERROR_EXIT(xs == 0 || ys == 0, "[ERROR]: Out of memory for %zu vertices\n", expected);
+        } else if (sscanf(line, "%d %d", &x, &y) == 2 && count < expected) {
+            xs[count] = x;
+            ys[count] = y;
+            count += 1;
+        } else {
+            valid = false;
+        }
+    }
+
+    if (valid && count == expected && count > 0) line_array_add_contour(lines, xs, ys, count);
+    else valid = false;
+
+    SDL_free(xs);
+    SDL_free(ys);
+    
+    return(valid);
+}
+
+// @Note: Binary scene file, laid out so a mapped file goes to the engines as is. Every section
+// starts on a SCENE_ALIGNMENT boundary:
+//
+//   Scene_Header
+//   lines     line_count x Line, edge by edge, contour after contour, 'next'/'prev' index the
+//             file's own lines. That's the start point of every vertex, the end point and the
+//             links the editor walks, the same bytes 'Line_Array' holds.
+//   contours  contour_count x Scene_Contour, where every contour's lines start and how many
+//   styles    style_count x Scene_Style, a colour and fill rule for a run of contours
+//
+// Everything is little-endian and a Line has 64 bit links, the header says so and a build
+// where that isn't true won't map it.
+#define SCENE_MAGIC 0x4E435344 // 'DSCN'
+#define SCENE_VERSION 1
+#define SCENE_ENDIAN 0x01020304
+#define SCENE_ALIGNMENT 64
+
+struct Scene_Header {
+    u32 magic;
+    u32 version;
+    u32 endian;
+    u32 line_size;
+    u64 line_count;
+    u64 contour_count;
+    u64 style_count;
+    u64 lines_offset;
+    u64 contours_offset;
+    u64 styles_offset;
+};
+
+enum Fill_Rule {
+    FILL_RULE_EVEN_ODD = 0,
+    FILL_RULE_NONZERO,
+};
+
+struct Scene_Contour {
+    u64 first_line;
+    u64 line_count;
+};
+
+// @Note: The engines only do even-odd over the whole scene, the first style colours the mask.
+struct Scene_Style {
+    u32 color;
+    u32 fill_rule;
+    u64 first_contour;
+    u64 contour_count;
+};
+
+struct Scene_Map {
+    u8 *memory;
+    size_t size;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+internal void scene_write_padding(FILE *file, u64 *offset)
+{
+    static const u8 zeros[SCENE_ALIGNMENT] = {};
+    u64 padding = ALIGN_UP(*offset, SCENE_ALIGNMENT) - *offset;
+    fwrite(zeros, 1, (size_t) padding, file);
+    *offset += padding;
+}
+
+// @Note: Writes the contours of 'lines' packed one after the other, whatever order edits left
+// them in. Returns false if writing failed.
+internal bool scene_write_binary(Line_Array *lines, u32 color, FILE *file)
+{
+    u8 *visited = (u8 *) SDL_calloc(lines->size + 1, 1);
+    Scene_Contour *contours = (Scene_Contour *) SDL_malloc((lines->size + 1) * sizeof(Scene_Contour));
+    ERROR_EXIT(visited == 0 || contours == 0, "[ERROR]: Out of memory for %zu lines\n", lines->size);
+
+    u64 contour_count = 0;
+    u64 line_count = 0;
+    for (size_t start = 0; start < lines->size; ++start) {
+        if (visited[start]) continue;
+
+        Scene_Contour *contour = &contours[contour_count++];
+        contour->first_line = line_count;
+        contour->line_count = 0;
+
+        size_t i = start;
+        do {
+            visited[i] = 1;
+            contour->line_count += 1;
+            i = lines->data[i].next;
+        } while (i != start);
+
+        line_count += contour->line_count;
+    }
+
+    Scene_Header header = {};
+    header.magic = SCENE_MAGIC;
+    header.version = SCENE_VERSION;
+    header.endian = SCENE_ENDIAN;
+    header.line_size = sizeof(Line);
+    header.line_count = line_count;
+    header.contour_count = contour_count;
+    header.style_count = 1;
+    header.lines_offset = ALIGN_UP(sizeof(Scene_Header), SCENE_ALIGNMENT);
+    header.contours_offset = ALIGN_UP(header.lines_offset + line_count * sizeof(Line), SCENE_ALIGNMENT);
+    header.styles_offset = ALIGN_UP(header.contours_offset + contour_count * sizeof(Scene_Contour), SCENE_ALIGNMENT);
+
+    u64 offset = sizeof(header);
+    fwrite(&header, sizeof(header), 1, file);
+    scene_write_padding(file, &offset);
+
+    // @Note: Contours got numbered in the order their first line shows up, same walk again.
+    memset(visited, 0, lines->size);
+    size_t start = 0;
+    for (u64 c = 0; c < contour_count; ++c) {
+        Scene_Contour *contour = &contours[c];
+        while (visited[start]) start += 1;
+
+        size_t i = start;
+        for (u64 k = 0; k < contour->line_count; ++k) {
+            visited[i] = 1;
+
+            Line line = lines->data[i];
+            line.next = (size_t) (contour->first_line + (k + 1) % contour->line_count);
+            line.prev = (size_t) (contour->first_line + (k + contour->line_count - 1) % contour->line_count);
+            fwrite(&line, sizeof(line), 1, file);
+
+            i = lines->data[i].next;
+        }
+    }
+    offset += line_count * sizeof(Line);
+    scene_write_padding(file, &offset);
+
+    fwrite(contours, sizeof(Scene_Contour), (size_t) contour_count, file);
+    offset += contour_count * sizeof(Scene_Contour);
+    scene_write_padding(file, &offset);
+
+    Scene_Style style = {};
+    style.color = color;
+    style.fill_rule = FILL_RULE_EVEN_ODD;
+    style.first_contour = 0;
+    style.contour_count = contour_count;
+    fwrite(&style, sizeof(style), 1, file);
+
+    SDL_free(contours);
+    SDL_free(visited);
+
+    return(!ferror(file));
+}
+
+internal bool scene_file_is_binary(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return(false);
+
+    u8 magic[4] = {};
+    size_t got = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+
+    return(got == sizeof(magic) && read_u32_le(magic) == SCENE_MAGIC);
+}
+
+// @Note: Maps the whole file copy-on-write, writing to it changes our pages and never the file.
+internal bool scene_map(Scene_Map *map, const char *path)
+{
+    *map = {};
+
+#if defined(_WIN32)
+    map->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (map->file == INVALID_HANDLE_VALUE) return(false);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(map->file, &size) || size.QuadPart == 0) {
+        CloseHandle(map->file);
+        return(false);
+    }
+
+    map->mapping = CreateFileMappingA(map->file, 0, PAGE_WRITECOPY, 0, 0, 0);
+    map->memory = map->mapping ? (u8 *) MapViewOfFile(map->mapping, FILE_MAP_COPY, 0, 0, 0) : 0;
+    if (!map->memory) {
+        if (map->mapping) CloseHandle(map->mapping);
+        CloseHandle(map->file);
+        return(false);
+    }
+    map->size = (size_t) size.QuadPart;
+#elif defined(RASTER_POSIX)
+    s32 fd = open(path, O_RDONLY);
+    if (fd < 0) return(false);
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return(false);
+    }
+
+    void *memory = mmap(0, (size_t) info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) return(false);
+
+    map->memory = (u8 *) memory;
+    map->size = (size_t) info.st_size;
+#else
+    // @Note: Nothing to map with, reads the file instead.
+    FILE *file = fopen(path, "rb");
+    if (!file) return(false);
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    map->memory = size > 0 ? (u8 *) SDL_malloc((size_t) size) : 0;
+    if (!map->memory || fread(map->memory, 1, (size_t) size, file) != (size_t) size) {
+        SDL_free(map->memory);
+        fclose(file);
+        return(false);
+    }
+    map->size = (size_t) size;
+    fclose(file);
+#endif
+
+    return(true);
+}
+
+internal void scene_unmap(Scene_Map *map)
+{
+    if (!map->memory) return;
+
+#if defined(_WIN32)
+    UnmapViewOfFile(map->memory);
+    CloseHandle(map->mapping);
+    CloseHandle(map->file);
+#elif defined(RASTER_POSIX)
+    munmap(map->memory, map->size);
+#else
+    SDL_free(map->memory);
+#endif
+
+    *map = {};
+}
+
+internal bool scene_section_fits(Scene_Map *map, u64 offset, u64 count, u64 size)
+{
+    if (offset % SCENE_ALIGNMENT != 0 || offset > map->size) return(false);
+    return(count <= (map->size - offset) / size);
+}
+
+// @Note: Hands the mapped lines to 'lines' without copying them. They get read once to check
+// their links, every 'next' and 'prev' has to be in range and point back, since the editor and
+// the writers follow them blindly. That pass faults in every page of the lines, about 6 ms per
+// million lines from the page cache. 'lines' borrows the mapping, it has to stay mapped while
+// they're in use.
+internal bool scene_open_binary(Scene_Map *map, const char *path, Line_Array *lines, u32 *color)
+{
+    if (!scene_map(map, path)) return(false);
+
+    Scene_Header *header = (Scene_Header *) map->memory;
+    bool valid = map->size >= sizeof(Scene_Header) && header->magic == SCENE_MAGIC && header->version == SCENE_VERSION &&
+                 header->endian == SCENE_ENDIAN && header->line_size == sizeof(Line) && header->line_count > 0 &&
+                 scene_section_fits(map, header->lines_offset, header->line_count, sizeof(Line)) &&
+                 scene_section_fits(map, header->contours_offset, header->contour_count, sizeof(Scene_Contour)) &&
+                 scene_section_fits(map, header->styles_offset, header->style_count, sizeof(Scene_Style));
+    Line *mapped = (Line *) (map->memory + header->lines_offset);
+    for (size_t i = 0; i < header->line_count && valid; ++i) {
+        size_t next = mapped[i].next;
+        valid = next < header->line_count && mapped[i].prev < header->line_count && mapped[next].prev == i;
+    }
+
+    if (!valid) {
+        scene_unmap(map);
+        return(false);
+    }
+
+    line_array_free(lines);
+    lines->data = mapped;
+    lines->size = (size_t) header->line_count;
+    lines->capacity = lines->size;
+    lines->borrowed = true;
+
+    Scene_Style *styles = (Scene_Style *) (map->memory + header->styles_offset);
+    *color = header->style_count > 0 ? styles[0].color : FILLED_COLOR;
+
+    return(true);
+}
+
+// @Note: Collects contours in whatever units an importer reads, 'contour_builder_to_lines' fits
+// them onto the grid at the end. Points only go through here once, contours with fewer than
+// three points are dropped.
+struct Contour_Builder {
+    f32 *xs;
+    f32 *ys;
+    size_t points;
+    size_t point_capacity;
+
+    u32 *sizes;
+    size_t contours;
+    size_t contour_capacity;
+
+    // @Note: First point of the contour that's being built.
+    size_t start;
+};
+
+internal void contour_builder_point(Contour_Builder *builder, f64 x, f64 y)
+{
+    if (builder->points == builder->point_capacity) {
+        builder->point_capacity = MAX(2 * builder->point_capacity, 1024);
+        builder->xs = (f32 *) SDL_realloc(builder->xs, builder->point_capacity * sizeof(f32));
+        builder->ys = (f32 *) SDL_realloc(builder->ys, builder->point_capacity * sizeof(f32));
+        ERROR_EXIT(builder->xs == 0 || builder->ys == 0, "[ERROR]: Out of memory for %zu imported points\n", builder->point_capacity);
+    }
+
+    builder->xs[builder->points] = (f32) x;
+    builder->ys[builder->points] = (f32) y;
+    builder->points += 1;
+}
+
+internal void contour_builder_close(Contour_Builder *builder)
+{
+    size_t count = builder->points - builder->start;
+
+    // @Note: Closing by going back to the first point is the same as not doing it.
+    if (count > 1 && builder->xs[builder->start] == builder->xs[builder->points - 1] && builder->ys[builder->start] == builder->ys[builder->points - 1]) {
+        builder->points -= 1;
+        count -= 1;
+    }
+
+    if (count < 3) {
+        builder->points = builder->start;
+        return;
+    }
+
+    if (builder->contours == builder->contour_capacity) {
+        builder->contour_capacity = MAX(2 * builder->contour_capacity, 256);
+        builder->sizes = (u32 *) SDL_realloc(builder->sizes, builder->contour_capacity * sizeof(u32));
+        ERROR_EXIT(builder->sizes == 0, "[ERROR]: Out of memory for %zu imported contours\n", builder->contour_capacity);
+    }
+
+    builder->sizes[builder->contours++] = (u32) count;
+    builder->start = builder->points;
+}
+
+internal void contour_builder_free(Contour_Builder *builder)
+{
+    SDL_free(builder->xs);
+    SDL_free(builder->ys);
+    SDL_free(builder->sizes);
+    *builder = {};
+}
+
+// @Note: Replaces whatever 'lines' held. Scales the view (x, y, width, height) to fit the grid
+// keeping its aspect and centres it. Without a view the bounds of the points are used.
+internal void contour_builder_to_lines(Contour_Builder *builder, Line_Array *lines, const f64 *view)
+{
+    lines->size = 0;
+    if (builder->contours == 0) return;
+
+    f64 view_x, view_y, view_w, view_h;
+    if (view && view[2] > 0.0 && view[3] > 0.0) {
+        view_x = view[0];
+        view_y = view[1];
+        view_w = view[2];
+        view_h = view[3];
+    } else {
+        f32 min_x = builder->xs[0], max_x = builder->xs[0];
+        f32 min_y = builder->ys[0], max_y = builder->ys[0];
+        for (size_t i = 1; i < builder->points; ++i) {
+            min_x = MIN(min_x, builder->xs[i]);
+            max_x = MAX(max_x, builder->xs[i]);
+            min_y = MIN(min_y, builder->ys[i]);
+            max_y = MAX(max_y, builder->ys[i]);
+        }
+
+        view_x = min_x;
+        view_y = min_y;
+        view_w = MAX((f64) max_x - min_x, 1e-9);
+        view_h = MAX((f64) max_y - min_y, 1e-9);
+    }
+
+    f64 scale = MIN(RECT_ROWS / view_w, RECT_COLS / view_h) * FIXED_ONE;
+    f64 offset_x = (FIXED_FROM_CELLS(RECT_ROWS) - view_w * scale) / 2.0 - view_x * scale;
+    f64 offset_y = (FIXED_FROM_CELLS(RECT_COLS) - view_h * scale) / 2.0 - view_y * scale;
+
+    u32 largest = 0;
+    for (size_t c = 0; c < builder->contours; ++c) largest = MAX(largest, builder->sizes[c]);
+
+    s32 *xs = (s32 *) SDL_malloc(largest * sizeof(s32));
+    s32 *ys = (s32 *) SDL_malloc(largest * sizeof(s32));
+    ERROR_EXIT(xs == 0 || ys == 0, "[ERROR]: Out of memory for %u vertices\n", largest);
+    line_array_reserve(lines, builder->points);
+
+    size_t first = 0;
+    for (size_t c = 0; c < builder->contours; ++c) {
+        u32 count = builder->sizes[c];
+        for (u32 i = 0; i < count; ++i) {
+            xs[i] = (s32) floor(builder->xs[first + i] * scale + offset_x + 0.5);
+            ys[i] = (s32) floor(builder->ys[first + i] * scale + offset_y + 0.5);
+        }
+
+        line_array_add_contour(lines, xs, ys, count);
+        first += count;
+    }
+
+    SDL_free(xs);
+    SDL_free(ys);
+}
+
+// @Note: Helpers for the text importers. They work on ranges of a file, nothing has to be
+// terminated or copied out.
+struct Text_Range {
+    const char *at;
+    const char *end;
+};
+
+internal inline bool text_is_space(char c)
+{
+    return(c == ' ' || c == '\t' || c == '\n' || c == '\r');
+}
+
+internal inline bool text_is_digit(char c)
+{
+    return(c >= '0' && c <= '9');
+}
+
+internal inline void text_skip_separators(const char **at, const char *end)
+{
+    while (*at < end && (text_is_space(**at) || **at == ',')) *at += 1;
+}
+
+// @Note: Numbers the way SVG writes them, "-1.5e3", ".5.5" being two and "1-2" too. No strtod,
+// it's locale dependent and wants a terminated string.
+internal bool text_number(const char **cursor, const char *end, f64 *value)
+{
+    static const f64 powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *at = *cursor;
+    text_skip_separators(&at, end);
+
+    bool negative = false;
+    if (at < end && (*at == '-' || *at == '+')) negative = *at++ == '-';
+
+    u64 mantissa = 0;
+    s32 exponent = 0;
+    s32 digits = 0;
+    while (at < end && text_is_digit(*at)) {
+        if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + (u64) (*at - '0');
+        else exponent += 1;
+        at += 1;
+        digits += 1;
+    }
+
+    if (at < end && *at == '.') {
+        at += 1;
+        while (at < end && text_is_digit(*at)) {
+            if (mantissa < 100000000000000000ull) {
+                mantissa = mantissa * 10 + (u64) (*at - '0');
+                exponent -= 1;
+            }
+            at += 1;
+            digits += 1;
+        }
+    }
+
+    if (digits == 0) return(false);
+
+    if (at + 1 < end && (*at == 'e' || *at == 'E') && (text_is_digit(at[1]) || ((at[1] == '-' || at[1] == '+') && at + 2 < end && text_is_digit(at[2])))) {
+        at += 1;
+        bool negative_exponent = false;
+        if (*at == '-' || *at == '+') negative_exponent = *at++ == '-';
+
+        s32 written = 0;
+        while (at < end && text_is_digit(*at)) {
+            written = MIN(written * 10 + (*at - '0'), 10000);
+            at += 1;
+        }
+        exponent += negative_exponent ? -written : written;
+    }
+
+    f64 result = (f64) mantissa;
+    if (exponent >= 0) result *= exponent < (s32) ARRAY_LEN(powers) ? powers[exponent] : pow(10.0, exponent);
+    else result /= -exponent < (s32) ARRAY_LEN(powers) ? powers[-exponent] : pow(10.0, -exponent);
+
+    *value = negative ? -result : result;
+    *cursor = at;
+    return(true);
+}
+
+internal bool text_is(Text_Range text, const char *name)
+{
+    size_t length = strlen(name);
+    return((size_t) (text.end - text.at) == length && memcmp(text.at, name, length) == 0);
+}
+
+// @Note: SVG importer, one forward pass over the file without building a tree. Tags and
+// attributes are looked at where they are in the file, nothing gets copied or allocated per
+// token. Takes <path>, <polygon>, <polyline>, <rect>, <circle> and <ellipse> with 'transform'
+// on them or on groups around them. Everything is filled even-odd, shapes with 'fill="none"'
+// (strokes) and whatever is inside <defs>, <clipPath>, <mask>, <symbol>, <pattern> and
+// <marker> are skipped. Curves and arcs get flattened, no units, percentages, styles
+// sheets or <use>.
+#define SVG_DEPTH_MAX 64
+#define SVG_CURVE_POINTS 8
+#define SVG_ARC_STEP (3.14159265358979 / 16.0)
+#define SVG_CIRCLE_POINTS 32
+
+// @Note: x' = a*x + c*y + e, y' = b*x + d*y + f, same as SVG's matrix().
+struct Svg_Transform {
+    f64 a, b, c, d, e, f;
+};
+
+struct Svg_Group {
+    Svg_Transform transform;
+    bool hidden;
+    bool no_fill;
+};
+
+struct Svg_Importer {
+    Contour_Builder *builder;
+
+    Svg_Group groups[SVG_DEPTH_MAX];
+    s32 depth;
+
+    bool have_root;
+    f64 view[4];
+
+    u64 shapes;
+    u64 skipped;
+};
+
+// @Note: Arc flags can be written without anything between them, "a1 1 0 111 1".
+internal bool svg_flag(const char **cursor, const char *end, bool *flag)
+{
+    const char *at = *cursor;
+    text_skip_separators(&at, end);
+    if (at >= end || (*at != '0' && *at != '1')) return(false);
+
+    *flag = *at == '1';
+    *cursor = at + 1;
+    return(true);
+}
+
+internal Svg_Transform svg_multiply(Svg_Transform m, Svg_Transform n)
+{
+    Svg_Transform r;
+    r.a = m.a * n.a + m.c * n.b;
+    r.b = m.b * n.a + m.d * n.b;
+    r.c = m.a * n.c + m.c * n.d;
+    r.d = m.b * n.c + m.d * n.d;
+    r.e = m.a * n.e + m.c * n.f + m.e;
+    r.f = m.b * n.e + m.d * n.f + m.f;
+    return(r);
+}
+
+internal inline void svg_point(Svg_Importer *svg, Svg_Transform *m, f64 x, f64 y)
+{
+    contour_builder_point(svg->builder, m->a * x + m->c * y + m->e, m->b * x + m->d * y + m->f);
+}
+
+// @Note: "translate(10 20) rotate(45)" and so on, applied left to right onto 'm'.
+internal Svg_Transform svg_parse_transform(Text_Range text, Svg_Transform m)
+{
+    const char *at = text.at;
+
+    while (at < text.end) {
+        while (at < text.end && (text_is_space(*at) || *at == ',')) at += 1;
+
+        const char *name = at;
+        while (at < text.end && *at != '(') at += 1;
+        Text_Range function = {name, at};
+        while (function.end > function.at && text_is_space(function.end[-1])) function.end -= 1;
+        if (at >= text.end) break;
+        at += 1;
+
+        f64 args[6] = {};
+        s32 count = 0;
+        while (count < 6 && text_number(&at, text.end, &args[count])) count += 1;
+        while (at < text.end && *at != ')') at += 1;
+        at += 1;
+
+        const f64 degrees = 3.14159265358979 / 180.0;
+        Svg_Transform n = {1, 0, 0, 1, 0, 0};
+        if (text_is(function, "matrix") && count == 6) {
+            n = {args[0], args[1], args[2], args[3], args[4], args[5]};
+        } else if (text_is(function, "translate") && count >= 1) {
+            n.e = args[0];
+            n.f = count > 1 ? args[1] : 0.0;
+        } else if (text_is(function, "scale") && count >= 1) {
+            n.a = args[0];
+            n.d = count > 1 ? args[1] : args[0];
+        } else if (text_is(function, "rotate") && count >= 1) {
+            f64 c = cos(args[0] * degrees);
+            f64 s = sin(args[0] * degrees);
+            n = {c, s, -s, c, 0, 0};
+            if (count == 3) {
+                Svg_Transform to = {1, 0, 0, 1, args[1], args[2]};
+                Svg_Transform back = {1, 0, 0, 1, -args[1], -args[2]};
+                n = svg_multiply(to, svg_multiply(n, back));
+            }
+        } else if (text_is(function, "skewX") && count >= 1) {
+            n.c = tan(args[0] * degrees);
+        } else if (text_is(function, "skewY") && count >= 1) {
+            n.b = tan(args[0] * degrees);
+        }
+
+        m = svg_multiply(m, n);
+    }
+
+    return(m);
+}
+
+// @Note: SVG's endpoint to centre conversion (implementation notes, F.6.5), then flattened with
+// a point every SVG_ARC_STEP radians. The start point is already out.
+internal void svg_arc(Svg_Importer *svg, Svg_Transform *m, f64 x0, f64 y0, f64 rx, f64 ry, f64 angle, bool large, bool sweep, f64 x1, f64 y1)
+{
+    if (x0 == x1 && y0 == y1) return;
+
+    rx = fabs(rx);
+    ry = fabs(ry);
+    if (rx == 0.0 || ry == 0.0) {
+        svg_point(svg, m, x1, y1);
+        return;
+    }
+
+    const f64 tau = 2.0 * 3.14159265358979;
+    f64 c = cos(angle * tau / 360.0);
+    f64 s = sin(angle * tau / 360.0);
+    f64 dx = (x0 - x1) / 2.0;
+    f64 dy = (y0 - y1) / 2.0;
+    f64 x1p = c * dx + s * dy;
+    f64 y1p = -s * dx + c * dy;
+
+    // @Note: Radii too small to reach get scaled up just enough.
+    f64 lambda = (x1p * x1p) / (rx * rx) + (y1p * y1p) / (ry * ry);
+    if (lambda > 1.0) {
+        rx *= sqrt(lambda);
+        ry *= sqrt(lambda);
+    }
+
+    f64 numerator = rx * rx * ry * ry - rx * rx * y1p * y1p - ry * ry * x1p * x1p;
+    f64 denominator = rx * rx * y1p * y1p + ry * ry * x1p * x1p;
+    f64 coefficient = denominator > 0.0 ? sqrt(MAX(numerator / denominator, 0.0)) : 0.0;
+    if (large == sweep) coefficient = -coefficient;
+
+    f64 cxp = coefficient * rx * y1p / ry;
+    f64 cyp = -coefficient * ry * x1p / rx;
+    f64 cx = c * cxp - s * cyp + (x0 + x1) / 2.0;
+    f64 cy = s * cxp + c * cyp + (y0 + y1) / 2.0;
+
+    f64 ux = (x1p - cxp) / rx, uy = (y1p - cyp) / ry;
+    f64 vx = (-x1p - cxp) / rx, vy = (-y1p - cyp) / ry;
+    f64 theta = atan2(uy, ux);
+    f64 delta = atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+    if (!sweep && delta > 0.0) delta -= tau;
+    else if (sweep && delta < 0.0) delta += tau;
+
+    s32 steps = MAX((s32) ceil(fabs(delta) / SVG_ARC_STEP), 1);
+    for (s32 i = 1; i < steps; ++i) {
+        f64 t = theta + delta * i / steps;
+        svg_point(svg, m, c * rx * cos(t) - s * ry * sin(t) + cx, s * rx * cos(t) + c * ry * sin(t) + cy);
+    }
+    svg_point(svg, m, x1, y1);
+}
+
+internal void svg_cubic(Svg_Importer *svg, Svg_Transform *m, f64 x0, f64 y0, f64 x1, f64 y1, f64 x2, f64 y2, f64 x3, f64 y3)
+{
+    for (s32 i = 1; i <= SVG_CURVE_POINTS; ++i) {
+        f64 t = (f64) i / SVG_CURVE_POINTS;
+        f64 u = 1.0 - t;
+        svg_point(svg, m, u*u*u*x0 + 3.0*u*u*t*x1 + 3.0*u*t*t*x2 + t*t*t*x3, u*u*u*y0 + 3.0*u*u*t*y1 + 3.0*u*t*t*y2 + t*t*t*y3);
+    }
+}
+
+internal void svg_quadratic(Svg_Importer *svg, Svg_Transform *m, f64 x0, f64 y0, f64 x1, f64 y1, f64 x2, f64 y2)
+{
+    for (s32 i = 1; i <= SVG_CURVE_POINTS; ++i) {
+        f64 t = (f64) i / SVG_CURVE_POINTS;
+        f64 u = 1.0 - t;
+        svg_point(svg, m, u*u*x0 + 2.0*u*t*x1 + t*t*x2, u*u*y0 + 2.0*u*t*y1 + t*t*y2);
+    }
+}
+
+// @Note: Path data, every subpath becomes a contour. Stops at the first thing that doesn't
+// parse and keeps what came before, like a renderer would.
+internal void svg_path(Svg_Importer *svg, Svg_Transform *m, Text_Range data)
+{
+    Contour_Builder *builder = svg->builder;
+    const char *at = data.at;
+    const char *end = data.end;
+
+    f64 x = 0, y = 0;
+    f64 start_x = 0, start_y = 0;
+    f64 control_x = 0, control_y = 0;
+    char command = 0;
+    char previous = 0;
+    bool open = false;
+
+    for (;;) {
+        text_skip_separators(&at, end);
+        if (at >= end) break;
+
+        char c = *at;
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+            command = c;
+            at += 1;
+        } else if (command == 0 || command == 'Z' || command == 'z') {
+            break;
+        }
+
+        // @Note: Drawing on after a close starts a new subpath where the last one started.
+        if (!open && command != 'M' && command != 'm' && command != 'Z' && command != 'z') {
+            svg_point(svg, m, start_x, start_y);
+            open = true;
+        }
+
+        bool relative = command >= 'a';
+        f64 base_x = relative ? x : 0.0;
+        f64 base_y = relative ? y : 0.0;
+        f64 v[7];
+        bool ok = true;
+
+        switch (command) {
+            case 'M': case 'm': {
+                ok = text_number(&at, end, &v[0]) && text_number(&at, end, &v[1]);
+                if (!ok) break;
+
+                if (open) contour_builder_close(builder);
+                x = start_x = base_x + v[0];
+                y = start_y = base_y + v[1];
+                svg_point(svg, m, x, y);
+                open = true;
+
+                // @Note: More pairs after a move are line-tos.
+                command = relative ? 'l' : 'L';
+            } break;
+
+            case 'L': case 'l': {
+                ok = text_number(&at, end, &v[0]) && text_number(&at, end, &v[1]);
+                if (!ok) break;
+                x = base_x + v[0];
+                y = base_y + v[1];
+                svg_point(svg, m, x, y);
+            } break;
+
+            case 'H': case 'h': {
+                ok = text_number(&at, end, &v[0]);
+                if (!ok) break;
+                x = base_x + v[0];
+                svg_point(svg, m, x, y);
+            } break;
+
+            case 'V': case 'v': {
+                ok = text_number(&at, end, &v[0]);
+                if (!ok) break;
+                y = base_y + v[0];
+                svg_point(svg, m, x, y);
+            } break;
+
+            case 'C': case 'c': {
+                for (s32 i = 0; i < 6 && ok; ++i) ok = text_number(&at, end, &v[i]);
+                if (!ok) break;
+                control_x = base_x + v[2];
+                control_y = base_y + v[3];
+                svg_cubic(svg, m, x, y, base_x + v[0], base_y + v[1], control_x, control_y, base_x + v[4], base_y + v[5]);
+                x = base_x + v[4];
+                y = base_y + v[5];
+            } break;
+
+            case 'S': case 's': {
+                for (s32 i = 0; i < 4 && ok; ++i) ok = text_number(&at, end, &v[i]);
+                if (!ok) break;
+                bool smooth = previous == 'C' || previous == 'c' || previous == 'S' || previous == 's';
+                f64 x1 = smooth ? 2.0 * x - control_x : x;
+                f64 y1 = smooth ? 2.0 * y - control_y : y;
+                control_x = base_x + v[0];
+                control_y = base_y + v[1];
+                svg_cubic(svg, m, x, y, x1, y1, control_x, control_y, base_x + v[2], base_y + v[3]);
+                x = base_x + v[2];
+                y = base_y + v[3];
+            } break;
+
+            case 'Q': case 'q': {
+                for (s32 i = 0; i < 4 && ok; ++i) ok = text_number(&at, end, &v[i]);
+                if (!ok) break;
+                control_x = base_x + v[0];
+                control_y = base_y + v[1];
+                svg_quadratic(svg, m, x, y, control_x, control_y, base_x + v[2], base_y + v[3]);
+                x = base_x + v[2];
+                y = base_y + v[3];
+            } break;
+
+            case 'T': case 't': {
+                ok = text_number(&at, end, &v[0]) && text_number(&at, end, &v[1]);
+                if (!ok) break;
+                bool smooth = previous == 'Q' || previous == 'q' || previous == 'T' || previous == 't';
+                control_x = smooth ? 2.0 * x - control_x : x;
+                control_y = smooth ? 2.0 * y - control_y : y;
+                svg_quadratic(svg, m, x, y, control_x, control_y, base_x + v[0], base_y + v[1]);
+                x = base_x + v[0];
+                y = base_y + v[1];
+            } break;
+
+            case 'A': case 'a': {
+                bool large, sweep;
+                ok = text_number(&at, end, &v[0]) && text_number(&at, end, &v[1]) && text_number(&at, end, &v[2]) &&
+                     svg_flag(&at, end, &large) && svg_flag(&at, end, &sweep) && text_number(&at, end, &v[3]) && text_number(&at, end, &v[4]);
+                if (!ok) break;
+                svg_arc(svg, m, x, y, v[0], v[1], v[2], large, sweep, base_x + v[3], base_y + v[4]);
+                x = base_x + v[3];
+                y = base_y + v[4];
+            } break;
+
+            case 'Z': case 'z': {
+                if (open) contour_builder_close(builder);
+                open = false;
+                x = start_x;
+                y = start_y;
+            } break;
+
+            default: ok = false;
+        }
+
+        if (!ok) break;
+        previous = command;
+    }
+
+    if (open) contour_builder_close(builder);
+}
+
+// @Note: The numbers of 'points', pairwise.
+internal void svg_points(Svg_Importer *svg, Svg_Transform *m, Text_Range points)
+{
+    const char *at = points.at;
+    f64 x, y;
+    while (text_number(&at, points.end, &x) && text_number(&at, points.end, &y)) svg_point(svg, m, x, y);
+    contour_builder_close(svg->builder);
+}
+
+internal void svg_ellipse(Svg_Importer *svg, Svg_Transform *m, f64 cx, f64 cy, f64 rx, f64 ry)
+{
+    if (rx <= 0.0 || ry <= 0.0) return;
+
+    const f64 tau = 2.0 * 3.14159265358979;
+    for (s32 i = 0; i < SVG_CIRCLE_POINTS; ++i) {
+        f64 t = tau * i / SVG_CIRCLE_POINTS;
+        svg_point(svg, m, cx + rx * cos(t), cy + ry * sin(t));
+    }
+    contour_builder_close(svg->builder);
+}
+
+internal f64 svg_attribute_number(Text_Range text, f64 fallback)
+{
+    const char *at = text.at;
+    f64 value;
+    return(text.at && text_number(&at, text.end, &value) ? value : fallback);
+}
+
+// @Note: Finds where 'name' starts in 'text' or returns 0, for looking into style attributes.
+internal const char *svg_find(Text_Range text, const char *name)
+{
+    size_t length = strlen(name);
+    for (const char *at = text.at; at && at + length <= text.end; ++at) {
+        if (memcmp(at, name, length) == 0) return(at);
+    }
+
+    return(0);
+}
+
+// @Note: Attributes of the one tag that's being looked at, they point into the file.
+struct Svg_Tag {
+    Text_Range name;
+    Text_Range d, points, transform, fill, style, view_box;
+    Text_Range x, y, width, height, cx, cy, r, rx, ry;
+    bool closed;
+};
+
+// @Note: 'at' is right after the tag's '<'. Returns where the tag ends, after its '>'.
+internal const char *svg_parse_tag(const char *at, const char *end, Svg_Tag *tag)
+{
+    *tag = {};
+    const char *name = at;
+    while (at < end && !text_is_space(*at) && *at != '>' && *at != '/') at += 1;
+    tag->name = {name, at};
+
+    // @Note: No namespaces, 'svg:path' is a path.
+    for (const char *c = name; c < at; ++c) {
+        if (*c == ':') tag->name.at = c + 1;
+    }
+
+    while (at < end) {
+        while (at < end && text_is_space(*at)) at += 1;
+        if (at >= end) break;
+
+        if (*at == '>') return(at + 1);
+        if (*at == '/') {
+            tag->closed = true;
+            at += 1;
+            continue;
+        }
+
+        const char *attribute = at;
+        while (at < end && *at != '=' && *at != '>' && !text_is_space(*at)) at += 1;
+        Text_Range key = {attribute, at};
+        while (at < end && text_is_space(*at)) at += 1;
+        if (at >= end || *at != '=') continue;
+        at += 1;
+        while (at < end && text_is_space(*at)) at += 1;
+        if (at >= end || (*at != '"' && *at != '\'')) continue;
+
+        char quote = *at++;
+        const char *value_end = (const char *) memchr(at, quote, (size_t) (end - at));
+        if (!value_end) return(end);
+        Text_Range value = {at, value_end};
+        at = value_end + 1;
+
+        switch (key.end - key.at) {
+            case 1: {
+                if (*key.at == 'd') tag->d = value;
+                else if (*key.at == 'x') tag->x = value;
+                else if (*key.at == 'y') tag->y = value;
+                else if (*key.at == 'r') tag->r = value;
+            } break;
+
+            case 2: {
+                if (text_is(key, "cx")) tag->cx = value;
+                else if (text_is(key, "cy")) tag->cy = value;
+                else if (text_is(key, "rx")) tag->rx = value;
+                else if (text_is(key, "ry")) tag->ry = value;
+            } break;
+
+            default: {
+                if (text_is(key, "points")) tag->points = value;
+                else if (text_is(key, "transform")) tag->transform = value;
+                else if (text_is(key, "fill")) tag->fill = value;
+                else if (text_is(key, "style")) tag->style = value;
+                else if (text_is(key, "viewBox")) tag->view_box = value;
+                else if (text_is(key, "width")) tag->width = value;
+                else if (text_is(key, "height")) tag->height = value;
+            } break;
+        }
+    }
+
+    return(end);
+}
+
+internal bool svg_is_shape(Text_Range name)
+{
+    return(text_is(name, "path") || text_is(name, "polygon") || text_is(name, "polyline") ||
+           text_is(name, "rect") || text_is(name, "circle") || text_is(name, "ellipse"));
+}
+
+internal void svg_shape(Svg_Importer *svg, Svg_Tag *tag, Svg_Transform *m)
+{
+    Text_Range name = tag->name;
+
+    if (text_is(name, "path") && tag->d.at) {
+        svg_path(svg, m, tag->d);
+    } else if ((text_is(name, "polygon") || text_is(name, "polyline")) && tag->points.at) {
+        svg_points(svg, m, tag->points);
+    } else if (text_is(name, "rect")) {
+        f64 x = svg_attribute_number(tag->x, 0.0);
+        f64 y = svg_attribute_number(tag->y, 0.0);
+        f64 w = svg_attribute_number(tag->width, 0.0);
+        f64 h = svg_attribute_number(tag->height, 0.0);
+        if (w <= 0.0 || h <= 0.0) return;
+
+        // @Note: Rounded corners are quarter ellipses, same as an arc would give.
+        f64 rx = svg_attribute_number(tag->rx, -1.0);
+        f64 ry = svg_attribute_number(tag->ry, -1.0);
+        if (rx < 0.0) rx = MAX(ry, 0.0);
+        if (ry < 0.0) ry = rx;
+        rx = MIN(rx, w / 2.0);
+        ry = MIN(ry, h / 2.0);
+
+        if (rx > 0.0 && ry > 0.0) {
+            svg_point(svg, m, x + rx, y);
+            svg_point(svg, m, x + w - rx, y);
+            svg_arc(svg, m, x + w - rx, y, rx, ry, 0, false, true, x + w, y + ry);
+            svg_point(svg, m, x + w, y + h - ry);
+            svg_arc(svg, m, x + w, y + h - ry, rx, ry, 0, false, true, x + w - rx, y + h);
+            svg_point(svg, m, x + rx, y + h);
+            svg_arc(svg, m, x + rx, y + h, rx, ry, 0, false, true, x, y + h - ry);
+            svg_point(svg, m, x, y + ry);
+            svg_arc(svg, m, x, y + ry, rx, ry, 0, false, true, x + rx, y);
+        } else {
+            svg_point(svg, m, x, y);
+            svg_point(svg, m, x + w, y);
+            svg_point(svg, m, x + w, y + h);
+            svg_point(svg, m, x, y + h);
+        }
+        contour_builder_close(svg->builder);
+    } else if (text_is(name, "circle")) {
+        f64 r = svg_attribute_number(tag->r, 0.0);
+        svg_ellipse(svg, m, svg_attribute_number(tag->cx, 0.0), svg_attribute_number(tag->cy, 0.0), r, r);
+    } else if (text_is(name, "ellipse")) {
+        svg_ellipse(svg, m, svg_attribute_number(tag->cx, 0.0), svg_attribute_number(tag->cy, 0.0),
+                    svg_attribute_number(tag->rx, 0.0), svg_attribute_number(tag->ry, 0.0));
+    }
+
+    svg->shapes += 1;
+}
+
+internal bool svg_hides_children(Text_Range name)
+{
+    return(text_is(name, "defs") || text_is(name, "clipPath") || text_is(name, "mask") ||
+           text_is(name, "symbol") || text_is(name, "pattern") || text_is(name, "marker"));
+}
+
+// @Note: Adds every filled shape of the SVG in 'text' to 'builder' in the SVG's units. 'view'
+// gets the root's viewBox (or its width and height), zero when it has neither.
+internal void svg_import(Contour_Builder *builder, const char *text, size_t size, f64 *view, u64 *shapes, u64 *skipped)
+{
+    // @Note: Big, keep it off the stack.
+    static Svg_Importer svg;
+    svg = {};
+    svg.builder = builder;
+    svg.groups[0].transform = {1, 0, 0, 1, 0, 0};
+
+    const char *at = text;
+    const char *end = text + size;
+
+    while (at < end) {
+        const char *open = (const char *) memchr(at, '<', (size_t) (end - at));
+        if (!open || open + 1 >= end) break;
+        at = open + 1;
+
+        if (*at == '!') {
+            const char *close = 0;
+            if (end - at >= 3 && memcmp(at, "!--", 3) == 0) {
+                for (const char *c = at + 3; c + 2 < end && !close; ++c) {
+                    if (c[0] == '-' && c[1] == '-' && c[2] == '>') close = c + 3;
+                }
+            } else if (end - at >= 8 && memcmp(at, "![CDATA[", 8) == 0) {
+                for (const char *c = at + 8; c + 2 < end && !close; ++c) {
+                    if (c[0] == ']' && c[1] == ']' && c[2] == '>') close = c + 3;
+                }
+            } else {
+                close = (const char *) memchr(at, '>', (size_t) (end - at));
+                if (close) close += 1;
+            }
+
+            at = close ? close : end;
+            continue;
+        }
+
+        if (*at == '?' || *at == '/') {
+            // @Note: Deeper than we track, only the levels we have get popped.
+            if (*at == '/' && svg.depth > 0) svg.depth -= 1;
+
+            const char *close = (const char *) memchr(at, '>', (size_t) (end - at));
+            at = close ? close + 1 : end;
+            continue;
+        }
+
+        Svg_Tag tag;
+        at = svg_parse_tag(at, end, &tag);
+
+        Svg_Group *parent = &svg.groups[MIN(svg.depth, SVG_DEPTH_MAX - 1)];
+        Svg_Group group = *parent;
+        if (tag.transform.at) group.transform = svg_parse_transform(tag.transform, group.transform);
+        if (svg_hides_children(tag.name)) group.hidden = true;
+        if (tag.fill.at) group.no_fill = text_is(tag.fill, "none");
+        if (tag.style.at) {
+            const char *fill = svg_find(tag.style, "fill:");
+            if (fill) {
+                fill += 5;
+                while (fill < tag.style.end && text_is_space(*fill)) fill += 1;
+                group.no_fill = tag.style.end - fill >= 4 && memcmp(fill, "none", 4) == 0;
+            }
+        }
+
+        if (!svg.have_root && text_is(tag.name, "svg")) {
+            svg.have_root = true;
+
+            const char *view_at = tag.view_box.at;
+            if (!view_at || !text_number(&view_at, tag.view_box.end, &svg.view[0]) || !text_number(&view_at, tag.view_box.end, &svg.view[1]) ||
+                !text_number(&view_at, tag.view_box.end, &svg.view[2]) || !text_number(&view_at, tag.view_box.end, &svg.view[3])) {
+                svg.view[0] = svg.view[1] = 0.0;
+                svg.view[2] = svg_attribute_number(tag.width, 0.0);
+                svg.view[3] = svg_attribute_number(tag.height, 0.0);
+            }
+        }
+
+        if (!group.hidden && svg_is_shape(tag.name)) {
+            if (group.no_fill) svg.skipped += 1;
+            else svg_shape(&svg, &tag, &group.transform);
+        }
+
+        if (!tag.closed) {
+            svg.depth += 1;
+            if (svg.depth < SVG_DEPTH_MAX) svg.groups[svg.depth] = group;
+        }
+    }
+
+    memcpy(view, svg.view, sizeof(svg.view));
+    *shapes = svg.shapes;
+    *skipped = svg.skipped;
+}
+
+// @Note: GeoJSON and WKT importers. Geographic files are too big to map or read in whole, so
+// they get read GEO_CHUNK_SIZE at a time into one buffer. A chunk gets parsed up to its last
+// delimiter and the partial token after it is moved to the front for the next read, so
+// numbers and keywords are always whole when the parsers see them. Only JSON strings can
+// cross a chunk, the parser keeps its state for them. Only polygons and multipolygons make
+// contours, holes included, everything else is counted as skipped. Coordinates are taken
+// relative to the first one so the f32 points keep their precision far from the origin,
+// the builder fits the bounds onto the grid at the end.
+#define GEO_CHUNK_SIZE (1 << 20)
+#define GEO_DEPTH_MAX 64
+#define GEO_STRING_MAX 32
+#define GEO_MERCATOR_LAT_MAX 85.05112878
+
+enum Geo_Format {
+    GEO_GEOJSON,
+    GEO_WKT,
+};
+
+struct Geo_Importer {
+    Contour_Builder *builder;
+    Geo_Format format;
+
+    bool have_origin;
+    f64 origin_x;
+    f64 origin_y;
+
+    u64 shapes;
+    u64 skipped;
+
+    // @Note: The coordinates of the position being read, the rest of its numbers (z, m) are
+    // ignored.
+    f64 position[2];
+    u32 components;
+    bool ring_points;
+
+    // @Note: GeoJSON. 'kinds' is the geometry type of every open object, 'coordinates_depth'
+    // the object the coordinates being read belong to. Until that object closes it isn't
+    // known whether they were a polygon, its points get rolled back if they weren't.
+    u32 depth;
+    bool is_object[GEO_DEPTH_MAX];
+    s32 kinds[GEO_DEPTH_MAX];
+    s32 coordinates_depth;
+    u32 coordinates_level;
+    size_t mark_points;
+    size_t mark_contours;
+
+    bool in_string;
+    bool escape;
+    char string[GEO_STRING_MAX];
+    u32 string_length;
+    char key[GEO_STRING_MAX];
+    u32 key_length;
+    bool after_colon;
+
+    // @Note: WKT. The last tag decides what the parentheses after it are.
+    bool keep;
+    u32 parens;
+    u32 tag_parens;
+};
+
+enum Geo_Kind {
+    GEO_KIND_NONE,
+    GEO_KIND_POLYGON,
+    GEO_KIND_OTHER,
+};
+
+// @Note: GeoJSON is longitude/latitude (RFC 7946) and gets the web mercator projection. WKT
+// has no coordinate system of its own and is taken as already projected. Both have north
+// up, the grid has it down.
+internal void geo_position(Geo_Importer *geo)
+{
+    if (geo->components < 2) return;
+
+    f64 x = geo->position[0];
+    f64 y = geo->position[1];
+    if (geo->format == GEO_GEOJSON) {
+        f64 latitude = MIN(MAX(y, -GEO_MERCATOR_LAT_MAX), GEO_MERCATOR_LAT_MAX) * (3.14159265358979 / 180.0);
+        x = x * (3.14159265358979 / 180.0);
+        y = log(tan(3.14159265358979 / 4.0 + latitude / 2.0));
+    }
+
+    if (!geo->have_origin) {
+        geo->have_origin = true;
+        geo->origin_x = x;
+        geo->origin_y = y;
+    }
+
+    contour_builder_point(geo->builder, x - geo->origin_x, geo->origin_y - y);
+    geo->ring_points = true;
+}
+
+internal inline bool geo_is_delimiter(Geo_Format format, char c)
+{
+    if (text_is_space(c) || c == ',') return(true);
+    if (format == GEO_WKT) return(c == '(' || c == ')' || c == ';');
+    return(c == '[' || c == ']' || c == '{' || c == '}' || c == ':' || c == '"');
+}
+
+internal inline bool geo_is_number_start(char c)
+{
+    return(text_is_digit(c) || c == '-' || c == '+' || c == '.');
+}
+
+internal void geojson_close_object(Geo_Importer *geo)
+{
+    if (geo->coordinates_depth != (s32) geo->depth) return;
+
+    Contour_Builder *builder = geo->builder;
+    if (geo->kinds[MIN(geo->depth, GEO_DEPTH_MAX - 1)] == GEO_KIND_POLYGON) {
+        geo->shapes += 1;
+    } else {
+        builder->points = geo->mark_points;
+        builder->contours = geo->mark_contours;
+        builder->start = geo->mark_points;
+        geo->skipped += 1;
+    }
+
+    geo->coordinates_depth = -1;
+}
+
+// @Note: Only looks at the "type" of objects and their "coordinates", which can come in either
+// order. Properties and everything else get skipped without being looked at.
+internal void geojson_chunk(Geo_Importer *geo, const char *at, const char *end)
+{
+    Contour_Builder *builder = geo->builder;
+
+    while (at < end) {
+        if (geo->in_string) {
+            while (at < end) {
+                char c = *at++;
+                if (geo->escape) {
+                    geo->escape = false;
+                } else if (c == '\\') {
+                    geo->escape = true;
+                } else if (c == '"') {
+                    geo->in_string = false;
+                    break;
+                }
+
+                // @Note: Longer strings get cut, they're none of the names we look for.
+                if (geo->string_length < GEO_STRING_MAX) geo->string[geo->string_length++] = c;
+            }
+
+            if (geo->in_string) break;
+
+            if (geo->after_colon && geo->key_length == 4 && memcmp(geo->key, "type", 4) == 0 && geo->is_object[MIN(geo->depth, GEO_DEPTH_MAX - 1)]) {
+                bool polygon = (geo->string_length == 7 && memcmp(geo->string, "Polygon", 7) == 0) ||
+                               (geo->string_length == 12 && memcmp(geo->string, "MultiPolygon", 12) == 0);
+                geo->kinds[MIN(geo->depth, GEO_DEPTH_MAX - 1)] = polygon ? GEO_KIND_POLYGON : GEO_KIND_OTHER;
+            }
+            continue;
+        }
+
+        char c = *at;
+        if (geo->coordinates_level > 0 && geo_is_number_start(c)) {
+            f64 value;
+            if (!text_number(&at, end, &value)) {
+                at += 1;
+                continue;
+            }
+
+            if (geo->components < 2) geo->position[geo->components] = value;
+            geo->components += 1;
+            continue;
+        }
+
+        at += 1;
+        switch (c) {
+            case '"': {
+                geo->in_string = true;
+                geo->escape = false;
+                geo->string_length = 0;
+            } break;
+
+            case ':': {
+                memcpy(geo->key, geo->string, geo->string_length);
+                geo->key_length = geo->string_length;
+                geo->after_colon = true;
+            } break;
+
+            case ',': {
+                geo->after_colon = false;
+            } break;
+
+            case '{':
+            case '[': {
+                // @Note: Deeper than we track, the levels share the last slot.
+                geo->depth += 1;
+                u32 slot = MIN(geo->depth, GEO_DEPTH_MAX - 1);
+                geo->is_object[slot] = c == '{';
+                geo->kinds[slot] = GEO_KIND_NONE;
+
+                if (c == '[') {
+                    if (geo->coordinates_level > 0) {
+                        geo->coordinates_level += 1;
+                    } else if (geo->after_colon && geo->key_length == 11 && memcmp(geo->key, "coordinates", 11) == 0 &&
+                               geo->coordinates_depth < 0 && geo->is_object[MIN(geo->depth - 1, GEO_DEPTH_MAX - 1)]) {
+                        geo->coordinates_depth = (s32) geo->depth - 1;
+                        geo->coordinates_level = 1;
+                        geo->mark_points = builder->points;
+                        geo->mark_contours = builder->contours;
+                        geo->ring_points = false;
+                    }
+                    geo->components = 0;
+                }
+                geo->after_colon = false;
+            } break;
+
+            case '}':
+            case ']': {
+                if (geo->depth == 0) break;
+
+                if (c == '}') {
+                    geojson_close_object(geo);
+                } else if (geo->coordinates_level > 0) {
+                    // @Note: An array of numbers is a position, an array of positions a ring.
+                    if (geo->components > 0) {
+                        geo_position(geo);
+                    } else if (geo->ring_points) {
+                        contour_builder_close(builder);
+                        geo->ring_points = false;
+                    }
+
+                    geo->components = 0;
+                    geo->coordinates_level -= 1;
+                }
+
+                geo->depth -= 1;
+                geo->after_colon = false;
+            } break;
+        }
+    }
+}
+
+// @Note: Any number of geometries, one after the other or in a GEOMETRYCOLLECTION, with or
+// without an EWKT "SRID=...;" in front. Z, M and ZM coordinates are fine, only x and y are
+// used.
+internal void wkt_chunk(Geo_Importer *geo, const char *at, const char *end)
+{
+    Contour_Builder *builder = geo->builder;
+
+    while (at < end) {
+        char c = *at;
+
+        if (geo_is_number_start(c)) {
+            f64 value;
+            if (!text_number(&at, end, &value)) {
+                at += 1;
+                continue;
+            }
+
+            if (geo->keep) {
+                if (geo->components < 2) geo->position[geo->components] = value;
+                geo->components += 1;
+            }
+            continue;
+        }
+
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')) {
+            const char *word = at;
+            while (at < end && ((*at >= 'A' && *at <= 'Z') || (*at >= 'a' && *at <= 'z') || *at == '=' || text_is_digit(*at))) at += 1;
+
+            // @Note: Dimensions and EMPTY belong to the tag before them, SRID to nothing.
+            size_t length = (size_t) (at - word);
+            if (length <= 2 && (word[0] == 'Z' || word[0] == 'z' || word[0] == 'M' || word[0] == 'm')) continue;
+            if (length == 5 && SDL_strncasecmp(word, "EMPTY", 5) == 0) continue;
+            if (length >= 5 && SDL_strncasecmp(word, "SRID=", 5) == 0) continue;
+
+            bool polygon = (length == 7 && SDL_strncasecmp(word, "POLYGON", 7) == 0) ||
+                           (length == 12 && SDL_strncasecmp(word, "MULTIPOLYGON", 12) == 0);
+            bool collection = length == 18 && SDL_strncasecmp(word, "GEOMETRYCOLLECTION", 18) == 0;
+            if (!collection && !polygon) geo->skipped += 1;
+
+            geo->keep = polygon;
+            geo->tag_parens = geo->parens;
+            continue;
+        }
+
+        at += 1;
+        switch (c) {
+            case '(': {
+                geo->parens += 1;
+                if (geo->keep && geo->parens == geo->tag_parens + 1) geo->shapes += 1;
+                geo->components = 0;
+                geo->ring_points = false;
+            } break;
+
+            case ',': {
+                if (geo->keep && geo->components > 0) geo_position(geo);
+                geo->components = 0;
+            } break;
+
+            case ')': {
+                if (geo->parens == 0) break;
+
+                if (geo->keep) {
+                    if (geo->components > 0) geo_position(geo);
+                    if (geo->ring_points) contour_builder_close(builder);
+                }
+
+                geo->components = 0;
+                geo->ring_points = false;
+                geo->parens -= 1;
+                if (geo->parens == geo->tag_parens) geo->keep = false;
+            } break;
+        }
+    }
+}
+
+// @Note: Reads 'file' from wherever it is to its end. Returns the bytes read.
+internal u64 geo_import(Contour_Builder *builder, FILE *file, Geo_Format format, char *buffer, u64 *shapes, u64 *skipped)
+{
+    Geo_Importer geo = {};
+    geo.builder = builder;
+    geo.format = format;
+    geo.coordinates_depth = -1;
+
+    u64 total = 0;
+    size_t carried = 0;
+    for (;;) {
+        size_t read = fread(buffer + carried, 1, GEO_CHUNK_SIZE - carried, file);
+        total += read;
+        size_t size = carried + read;
+        bool last = read == 0 || feof(file);
+
+        // @Note: A token as big as the buffer can't be anything we read, it gets cut.
+        size_t cut = size;
+        if (!last) {
+            while (cut > 0 && !geo_is_delimiter(format, buffer[cut - 1])) cut -= 1;
+            if (cut == 0) cut = size;
+        }
+
+        if (format == GEO_GEOJSON) geojson_chunk(&geo, buffer, buffer + cut);
+        else wkt_chunk(&geo, buffer, buffer + cut);
+
+        carried = size - cut;
+        memmove(buffer, buffer + cut, carried);
+        if (last) break;
+    }
+
+    // @Note: A file that ends inside a ring still gets that ring.
+    contour_builder_close(builder);
+
+    *shapes = geo.shapes;
+    *skipped = geo.skipped;
+    return(total);
+}
+
+#define SCENE_CURVE_POINTS 8
+#define SCENE_CURVE_BULGE 1.3f
+
+// @Note: 'vertices' is the total over every contour, holes included. 'convexity' goes from 0,
+// where the distance of every vertex from the centre is random, to 1 where the contour is a
+// convex ellipse. 'intersections' is the fraction of vertices swapped with one of their next
+// few neighbours, each swap makes the contour cross itself. 'aspect' is width over height.
+// 'curves' is the fraction of edges that are quadratic curves, flattened into
+// SCENE_CURVE_POINTS lines each.
+struct Scene_Params {
+    u32 vertices;
+    f32 convexity;
+    f32 intersections;
+    f32 aspect;
+    u32 holes;
+    f32 curves;
+};
+
+internal Scene_Params scene_params_default(void)
+{
+    Scene_Params params = {};
+    params.vertices = 64;
+    params.convexity = 0.7f;
+    params.intersections = 0.0f;
+    params.aspect = (f32) RECT_ROWS / (f32) RECT_COLS;
+    params.holes = 0;
+    params.curves = 0.0f;
+
+    return(params);
+}
+
+internal inline f32 scene_radius_factor(Random_Series *series, f32 convexity)
+{
+    return(convexity + (1.0f - convexity) * random_unit(series));
+}
+
+// @Note: Goes around the ellipse clockwise (on screen) placing 'count' vertices at even angles.
+internal void scene_contour(Random_Series *series, Scene_Params *params, f32 cx, f32 cy, f32 rx, f32 ry, s32 *xs, s32 *ys, u32 count)
+{
+    const f32 tau = 6.2831853f;
+    
+    f32 first_factor = scene_radius_factor(series, params->convexity);
+    f32 factor = first_factor;
+    u32 i = 0;
+    
+    while (i < count) {
+        u32 steps = 1;
+        if (count - i > SCENE_CURVE_POINTS && random_unit(series) < params->curves) steps = SCENE_CURVE_POINTS;
+
+        f32 next_factor = (i + steps == count) ? first_factor : scene_radius_factor(series, params->convexity);
+        f32 a0 = tau * (f32) i / (f32) count;
+        f32 a1 = tau * (f32) (i + steps) / (f32) count;
+        
+        f32 x0 = cx + cosf(a0) * rx * factor;
+        f32 y0 = cy + sinf(a0) * ry * factor;
+        f32 x2 = cx + cosf(a1) * rx * next_factor;
+        f32 y2 = cy + sinf(a1) * ry * next_factor;
+
+        // @Note: Control point sits between the end points, pushed outwards.
+        f32 control_factor = MAX(factor, next_factor) * SCENE_CURVE_BULGE;
+        f32 x1 = cx + cosf(0.5f * (a0 + a1)) * rx * control_factor;
+        f32 y1 = cy + sinf(0.5f * (a0 + a1)) * ry * control_factor;
+        
+        for (u32 j = 0; j < steps; ++j) {
+            f32 t = (f32) j / (f32) steps;
+            f32 u = 1.0f - t;
+            xs[i + j] = (s32) (u*u*x0 + 2.0f*u*t*x1 + t*t*x2);
+            ys[i + j] = (s32) (u*u*y0 + 2.0f*u*t*y1 + t*t*y2);
+        }
+        
+        factor = next_factor;
+        i += steps;
+    }
+
+    u32 swaps = (u32) (params->intersections * (f32) count);
+    for (u32 swap = 0; swap < swaps; ++swap) {
+        u32 a = random_next(series) % count;
+        u32 b = (a + 1 + random_next(series) % 3) % count;
+        
+        s32 tmp = xs[a]; xs[a] = xs[b]; xs[b] = tmp;
+        tmp = ys[a]; ys[a] = ys[b]; ys[b] = tmp;
+    }
+}
+
+// @Note: Replaces whatever 'lines' held with a generated scene, the same seed and parameters
+// give the same scene everywhere. An outer contour centred on the grid and 'holes' smaller
+// contours laid out on a grid inside of it. Holes stay inside the outer contour and away
+// from each other as long as 'convexity' is at least 0.5, below that they can poke out.
+internal void scene_generate(Line_Array *lines, Scene_Params *params, u64 seed)
+{
+    Random_Series series = random_seed(seed);
+    lines->size = 0;
+    
+    u32 vertices = MAX(params->vertices, 3);
+    u32 holes = params->holes;
+    u32 hole_vertices = 0;
+    if (holes > 0) {
+        hole_vertices = MAX(vertices / (2 * holes), 3);
+        holes = MIN(holes, (vertices - 3) / hole_vertices);
+    }
+    u32 outer_vertices = vertices - holes * hole_vertices;
+    
+    line_array_reserve(lines, vertices);
+    s32 *xs = (s32 *) SDL_malloc(MAX(outer_vertices, hole_vertices) * sizeof(s32));
+    s32 *ys = (s32 *) SDL_malloc(MAX(outer_vertices, hole_vertices) * sizeof(s32));
+    ERROR_EXIT(xs == 0 || ys == 0, "[ERROR]: Out of memory for %u vertices\n", outer_vertices);
+
+    // @Note: Leaves room for the curves bulging out.
+    f32 aspect = MAX(params->aspect, 0.01f);
+    f32 max_rx = 0.45f * (f32) FIXED_FROM_CELLS(RECT_ROWS) / SCENE_CURVE_BULGE;
+    f32 max_ry = 0.45f * (f32) FIXED_FROM_CELLS(RECT_COLS) / SCENE_CURVE_BULGE;
+    f32 rx = MIN(max_rx, max_ry * aspect);
+    f32 ry = rx / aspect;
+    f32 cx = 0.5f * (f32) FIXED_FROM_CELLS(RECT_ROWS);
+    f32 cy = 0.5f * (f32) FIXED_FROM_CELLS(RECT_COLS);
+    
+    scene_contour(&series, params, cx, cy, rx, ry, xs, ys, outer_vertices);
+    line_array_add_contour(lines, xs, ys, outer_vertices);
+
+    if (holes > 0) {
+        // @Note: Square inscribed into the smallest the outer contour can get.
+        u32 grid = 1;
+        while (grid * grid < holes) grid += 1;
+        
+        f32 inner = 0.7f * MAX(params->convexity, 0.5f);
+        f32 cell_x = 2.0f * inner * rx / (f32) grid;
+        f32 cell_y = 2.0f * inner * ry / (f32) grid;
+        
+        for (u32 hole = 0; hole < holes; ++hole) {
+            f32 hx = cx - inner * rx + cell_x * ((f32) (hole % grid) + 0.5f);
+            f32 hy = cy - inner * ry + cell_y * ((f32) (hole / grid) + 0.5f);
+            
+            scene_contour(&series, params, hx, hy, 0.3f * cell_x, 0.3f * cell_y, xs, ys, hole_vertices);
+            line_array_add_contour(lines, xs, ys, hole_vertices);
+        }
+    }
+
+    SDL_free(xs);
+    SDL_free(ys);
+}
+
+enum Diff_Shape {
+    DIFF_SHAPE_RANDOM = 0,
+    DIFF_SHAPE_SAMPLE_CENTRES,
+    DIFF_SHAPE_COLLINEAR,
+    DIFF_SHAPE_SPIKES,
+    DIFF_SHAPE_SELF_INTERSECTING,
+    DIFF_SHAPE_DEGENERATE,
+    DIFF_SHAPE_OFFSCREEN,
+    DIFF_SHAPE_GENERATED,
+    DIFF_SHAPE_COUNT,
+};
+
+global const char *diff_shape_names[DIFF_SHAPE_COUNT] = {
+    "random",
+    "sample centres",
+    "collinear",
+    "spikes",
+    "self-intersecting",
+    "degenerate",
+    "offscreen",
+    "generated",
+};
+
+// @Note: More than TILE_GROUP_LINES so the tiled engine has to go through several groups.
+#define DIFF_LINES_MAX (3 * TILE_GROUP_LINES)
+
+// @Note: Every kind of shape aims at something the engines could get wrong, vertices
+// and horizontal edges exactly on sample rows, runs of collinear edges, slivers thinner
+// than a cell, crossing edges, zero area back and forth edges and parts outside the grid.
+// On top of those come generated scenes with random parameters, see 'scene_generate'.
+internal void diff_make_shape(Diff_Shape shape, Random_Series *series, Line_Array *lines)
+{
+    const s32 max_x = FIXED_FROM_CELLS(RECT_ROWS);
+    const s32 max_y = FIXED_FROM_CELLS(RECT_COLS);
+    
+    s32 xs[DIFF_LINES_MAX];
+    s32 ys[DIFF_LINES_MAX];
+    size_t count = (size_t) random_range(series, 3, DIFF_LINES_MAX);
+
+    switch (shape) {
+        case DIFF_SHAPE_RANDOM: {
+            for (size_t i = 0; i < count; ++i) {
+                xs[i] = random_range(series, 0, max_x);
+                ys[i] = random_range(series, 0, max_y);
+            }
+        } break;
+
+        case DIFF_SHAPE_SAMPLE_CENTRES: {
+            // @Note: Keep reusing a handful of rows so we also get horizontal edges on samples.
+            for (size_t i = 0; i < count; ++i) {
+                xs[i] = cell_sample(random_range(series, 0, RECT_ROWS - 1));
+                ys[i] = cell_sample(random_range(series, 0, 3) * (RECT_COLS / 4) + random_range(series, 0, 2));
+            }
+        } break;
+
+        case DIFF_SHAPE_COLLINEAR: {
+            // @Note: A triangle with its edges split into collinear pieces, the corners are
+            // on the cell grid so every split point is exactly on the edge.
+            s32 cx[3], cy[3];
+            for (s32 i = 0; i < 3; ++i) {
+                cx[i] = FIXED_FROM_CELLS(random_range(series, 0, RECT_ROWS / 2)) * 2;
+                cy[i] = FIXED_FROM_CELLS(random_range(series, 0, RECT_COLS / 2)) * 2;
+            }
+
+            count = 0;
+            for (s32 i = 0; i < 3; ++i) {
+                s32 next = (i + 1) % 3;
+                s32 splits = random_range(series, 1, DIFF_LINES_MAX / 3);
+                for (s32 j = 0; j < splits; ++j) {
+                    xs[count] = cx[i] + (cx[next] - cx[i]) / splits * j;
+                    ys[count] = cy[i] + (cy[next] - cy[i]) / splits * j;
+                    count += 1;
+                }
+            }
+        } break;
+
+        case DIFF_SHAPE_SPIKES: {
+            s32 cx = random_range(series, max_x / 4, 3 * max_x / 4);
+            s32 cy = random_range(series, max_y / 4, 3 * max_y / 4);
+            count &= ~(size_t) 1;
+            count = MAX(count, 4);
+
+            for (size_t i = 0; i < count; ++i) {
+                f32 angle = 6.2831853f * (f32) i / (f32) count;
+                s32 radius = (i % 2) ? random_range(series, 0, FIXED_ONE) : random_range(series, FIXED_FROM_CELLS(4), max_y / 2);
+                xs[i] = cx + (s32) (cosf(angle) * (f32) radius);
+                ys[i] = cy + (s32) (sinf(angle) * (f32) radius);
+            }
+        } break;
+
+        case DIFF_SHAPE_SELF_INTERSECTING: {
+            // @Note: Star polygon, every 'step'-th point of a circle.
+            s32 cx = max_x / 2 + random_range(series, -FIXED_ONE, FIXED_ONE);
+            s32 cy = max_y / 2 + random_range(series, -FIXED_ONE, FIXED_ONE);
+            s32 radius = random_range(series, FIXED_FROM_CELLS(4), max_y / 2);
+            count = MAX(count, 5);
+            size_t step = (size_t) random_range(series, 2, (s32) (count - 1) / 2);
+
+            for (size_t i = 0; i < count; ++i) {
+                f32 angle = 6.2831853f * (f32) ((i * step) % count) / (f32) count;
+                xs[i] = cx + (s32) (cosf(angle) * (f32) radius);
+                ys[i] = cy + (s32) (sinf(angle) * (f32) radius);
+            }
+        } break;
+
+        case DIFF_SHAPE_DEGENERATE: {
+            // @Note: Random points where some get repeated and some edges go out and straight back.
+            for (size_t i = 0; i < count; ++i) {
+                u32 pick = random_next(series) % 4;
+                if (i > 0 && pick == 0) {
+                    xs[i] = xs[i - 1];
+                    ys[i] = ys[i - 1];
+                } else if (i > 1 && pick == 1) {
+                    xs[i] = xs[i - 2];
+                    ys[i] = ys[i - 2];
+                } else {
+                    xs[i] = random_range(series, 0, max_x);
+                    ys[i] = random_range(series, 0, max_y);
+                }
+            }
+        } break;
+
+        case DIFF_SHAPE_OFFSCREEN: {
+            for (size_t i = 0; i < count; ++i) {
+                xs[i] = random_range(series, -max_x / 2, max_x + max_x / 2);
+                ys[i] = random_range(series, -max_y / 2, max_y + max_y / 2);
+            }
+        } break;
+
+        case DIFF_SHAPE_GENERATED: {
+            Scene_Params params = scene_params_default();
+            params.vertices = (u32) random_range(series, 3, 4 * DIFF_LINES_MAX);
+            params.convexity = random_unit(series);
+            params.intersections = random_unit(series) * 0.2f;
+            params.aspect = 0.25f + 4.0f * random_unit(series);
+            params.holes = (u32) random_range(series, 0, 4);
+            params.curves = random_unit(series);
+
+            scene_generate(lines, &params, random_next(series));
+        } return;
+
+        default: assert(false && "Unknown diff shape");
+    }
+
+    lines->size = 0;
+    line_array_add_contour(lines, xs, ys, count);
+}
+
+// @Note: Returns false when the masks are the same, otherwise gives back the first
+// differing cell going row by row.
+internal bool coverage_mask_first_difference(Coverage_Mask *a, Coverage_Mask *b, s32 *x, s32 *y)
+{
+    for (s32 row = 0; row < RECT_COLS; ++row) {
+        for (s32 word = 0; word < MASK_WORDS; ++word) {
+            u64 diff = a->words[MASK_WORDS * row + word] ^ b->words[MASK_WORDS * row + word];
+            if (diff == 0) continue;
+
+            *x = word * 64 + (s32) lowest_set_bit64(diff);
+            *y = row;
+            return(true);
+        }
+    }
+
+    return(false);
+}
+
+internal inline bool coverage_mask_is_filled(Coverage_Mask *mask, s32 x, s32 y)
+{
+    return(((MASK_AT(mask->words, x, y) >> (x % 64)) & 1) != 0);
+}
+
+// @Note: Rasterizes 'lines' into every sink other than the mask, turns what each got back into
+// a mask and compares that with 'expected'. The grid keeps its stamps from one shape to the
+// next, so stale epochs get checked too. Returns the name of the first sink that differs, or 0.
+internal const char *diff_check_sinks(Line_Array *lines, Coverage_Mask *expected, s32 *x, s32 *y)
+{
+    static Raster_Grid grid;
+    static Span_Array spans;
+    static Rect_Batch rects;
+    static Coverage_Mask got;
+
+    Span_Sink grid_sink = span_sink_grid(&grid);
+    rasterize(RASTER_ENGINE_REFERENCE, lines, 1, &grid_sink, &frame_arena);
+    memset(got.words, 0, sizeof(got.words));
+    for (s32 row = 0; row < RECT_ROWS; ++row) {
+        for (s32 col = 0; col < RECT_COLS; ++col) {
+            if (raster_grid_is_filled(&grid, RECT_COLS * row + col)) coverage_mask_fill(&got, col, row, row + 1);
+        }
+    }
+    if (coverage_mask_first_difference(expected, &got, x, y)) return("grid");
+
+    Span_Sink spans_sink = span_sink_spans(&spans);
+    rasterize(RASTER_ENGINE_REFERENCE, lines, 1, &spans_sink, &frame_arena);
+    memset(got.words, 0, sizeof(got.words));
+    for (size_t i = 0; i < spans.size; ++i) coverage_mask_fill(&got, spans.data[i].y, spans.data[i].x0, spans.data[i].x1);
+    if (coverage_mask_first_difference(expected, &got, x, y)) return("spans");
+
+    Span_Sink rects_sink = span_sink_rects(&rects);
+    rasterize(RASTER_ENGINE_REFERENCE, lines, 1, &rects_sink, &frame_arena);
+    memset(got.words, 0, sizeof(got.words));
+    for (s32 i = 0; i < rects.size; ++i) {
+        SDL_Rect *rect = &rects.data[i];
+        if (rect->h != RECT_RES) {
+            *x = rect->x / RECT_RES;
+            *y = rect->y / RECT_RES;
+            return("rects");
+        }
+        coverage_mask_fill(&got, rect->y / RECT_RES, rect->x / RECT_RES, (rect->x + rect->w) / RECT_RES);
+    }
+    if (coverage_mask_first_difference(expected, &got, x, y)) return("rects");
+
+    return(0);
+}
+
+#define DIFF_KERNEL_WORDS 8
+#define DIFF_KERNEL_PIXELS 200
+
+internal u64 random_word(Random_Series *series)
+{
+    u64 word = ((u64) random_next(series) << 32) | random_next(series);
+
+    // @Note: Empty, full and sparse words as well, not only ones with half their bits set.
+    switch (random_range(series, 0, 3)) {
+        case 0: return(0);
+        case 1: return(~0ull);
+        case 2: return(word & (((u64) random_next(series) << 32) | random_next(series)));
+        default: return(word);
+    }
+}
+
+// @Note: One round of every kernel variant the CPU has against the scalar one on random input.
+// The sizes, ranges and alignments are random too, so the tails after the vector loops get
+// their turn. Returns the name of the first kernel that differs and sets 'variant', or 0.
+internal const char *diff_check_kernels(Random_Series *series, const Raster_Kernels **variant)
+{
+    static u64 a[DIFF_KERNEL_WORDS + 1];
+    static u64 b[DIFF_KERNEL_WORDS + 1];
+    static u64 expected_words[DIFF_KERNEL_WORDS + 1];
+    static u64 got_words[DIFF_KERNEL_WORDS + 1];
+    static u32 expected_pixels[DIFF_KERNEL_WORDS * 64];
+    static u32 got_pixels[DIFF_KERNEL_WORDS * 64];
+    static u32 argb[2 * DIFF_KERNEL_PIXELS];
+    static u8 expected_yuv[3 * DIFF_KERNEL_PIXELS];
+    static u8 got_yuv[3 * DIFF_KERNEL_PIXELS];
+    static const s32 tail_widths[] = {2, 14, 30, 62};
+
+    for (u32 i = 0; i < ARRAY_LEN(a); ++i) {
+        a[i] = random_word(series);
+        b[i] = random_range(series, 0, 1) ? a[i] ^ random_word(series) : random_word(series);
+    }
+
+    size_t offset = (size_t) random_range(series, 0, 1);
+    size_t words = (size_t) random_range(series, 0, DIFF_KERNEL_WORDS);
+    s32 x_first = random_range(series, 0, DIFF_KERNEL_WORDS * 64 - 1);
+    s32 x_last = random_range(series, x_first, DIFF_KERNEL_WORDS * 64 - 1);
+    u32 color = random_next(series);
+
+    // @Note: Widths shorter than any vector loop's step go through the tails alone.
+    for (u32 i = 0; i < ARRAY_LEN(argb); ++i) argb[i] = (u32) random_word(series);
+    s32 width = random_range(series, 0, 3) == 0 ? tail_widths[random_range(series, 0, (s32) ARRAY_LEN(tail_widths) - 1)] :
+        2 * random_range(series, 1, DIFF_KERNEL_PIXELS / 2);
+
+    memset(expected_words, 0, sizeof(expected_words));
+    u32 expected_count = raster_kernels_scalar.xor_popcount(a + offset, b + offset, expected_words, words);
+    for (u32 i = 0; i < ARRAY_LEN(expected_pixels); ++i) expected_pixels[i] = 0xDEADBEEF;
+    raster_kernels_scalar.fill_texels(a, x_first, x_last, expected_pixels, color);
+    memset(expected_yuv, 0xA5, sizeof(expected_yuv));
+    raster_kernels_scalar.yuv420_rows(argb, argb + width, width, expected_yuv, expected_yuv + width,
+                                      expected_yuv + 2 * width, expected_yuv + 2 * width + width / 2);
+
+    for (size_t i = 0; i < ARRAY_LEN(kernel_variants); ++i) {
+        *variant = kernel_variants[i];
+        if (*variant == &raster_kernels_scalar || !raster_kernels_supported(*variant)) continue;
+
+        memset(got_words, 0, sizeof(got_words));
+        u32 got_count = (*variant)->xor_popcount(a + offset, b + offset, got_words, words);
+        if (got_count != expected_count || memcmp(got_words, expected_words, sizeof(got_words)) != 0) return("xor_popcount");
+
+        for (u32 j = 0; j < ARRAY_LEN(got_pixels); ++j) got_pixels[j] = 0xDEADBEEF;
+        (*variant)->fill_texels(a, x_first, x_last, got_pixels, color);
+        if (memcmp(got_pixels, expected_pixels, sizeof(got_pixels)) != 0) return("fill_texels");
+
+        memset(got_yuv, 0xA5, sizeof(got_yuv));
+        (*variant)->yuv420_rows(argb, argb + width, width, got_yuv, got_yuv + width, got_yuv + 2 * width, got_yuv + 2 * width + width / 2);
+        if (memcmp(got_yuv, expected_yuv, sizeof(got_yuv)) != 0) return("yuv420_rows");
+    }
+
+    return(0);
+}
+
+// @Note: Geographic data without a single polygon to fill, the importer has to come back with
+// no contours so 'import_scene' refuses it instead of handing the engines an empty scene.
+struct Diff_Empty_Geo {
+    const char *name;
+    Geo_Format format;
+    const char *text;
+};
+
+global Diff_Empty_Geo diff_empty_geo[] = {
+    {"empty WKT polygons", GEO_WKT, "POLYGON EMPTY\nMULTIPOLYGON EMPTY\n"},
+    {"WKT points and lines", GEO_WKT, "POINT (1 2)\nLINESTRING (0 0, 1 1)\n"},
+    {"GeoJSON points and lines", GEO_GEOJSON,
+     "{\"type\": \"FeatureCollection\", \"features\": ["
+     "{\"type\": \"Feature\", \"geometry\": {\"type\": \"Point\", \"coordinates\": [1, 2]}},"
+     "{\"type\": \"Feature\", \"geometry\": {\"type\": \"LineString\", \"coordinates\": [[0, 0], [1, 1]]}}]}"},
+};
+
+// @Note: Streams every 'diff_empty_geo' input through 'geo_import'. Returns the name of the
+// first one that made contours, or 0.
+internal const char *diff_check_empty_geo(void)
+{
+    char *buffer = (char *) SDL_malloc(GEO_CHUNK_SIZE);
+    ERROR_EXIT(buffer == 0, "[ERROR]: Out of memory for the import buffer\n");
+
+    const char *failed = 0;
+    for (u32 i = 0; i < ARRAY_LEN(diff_empty_geo) && !failed; ++i) {
+        Diff_Empty_Geo *input = &diff_empty_geo[i];
+        FILE *file = tmpfile();
+        ERROR_EXIT(file == 0, "[ERROR]: Could not create a temporary file for '%s'\n", input->name);
+        fputs(input->text, file);
+        rewind(file);
+
+        Contour_Builder builder = {};
+        u64 shapes, skipped;
+        geo_import(&builder, file, input->format, buffer, &shapes, &skipped);
+        if (builder.contours != 0) failed = input->name;
+
+        contour_builder_free(&builder);
+        fclose(file);
+    }
+
+    SDL_free(buffer);
+    return(failed);
+}
+
+// @Note: Runs every engine against 'rasterize_shape' on 'count' generated shapes and stops at the
+// first one they disagree on. Every span sink has to agree with the mask on the same shapes.
+// The kernels other than the crossing test, which the engines already cover, get a round of
+// random input against the scalar ones per shape. The geographic importer has to make nothing
+// out of 'diff_empty_geo' first. Returns the number of mismatches (0 or 1).
+internal s32 run_differential_check(u32 count, u64 seed)
+{
+    static Coverage_Mask expected;
+    static Coverage_Mask got;
+    Line_Array lines = {};
+    s32 mismatches = 0;
+    
+    Random_Series series = random_seed(seed);
+    Random_Series kernel_series = random_seed(~seed);
+    u32 shapes_per_kind[DIFF_SHAPE_COUNT] = {0};
+    const Raster_Kernels *selected = kernels;
+
+    const char *geo = diff_check_empty_geo();
+    if (geo) {
+        fprintf(stderr, "[ERROR]: Importing %s made contours, there's nothing to fill in them\n", geo);
+        return(1);
+    }
+    
+    for (u32 index = 0; index < count; ++index) {
+        Diff_Shape shape = (Diff_Shape) (index % DIFF_SHAPE_COUNT);
+        diff_make_shape(shape, &series, &lines);
+        shapes_per_kind[shape] += 1;
+        arena_reset(&frame_arena);
+
+        Span_Sink expected_sink = span_sink_mask(&expected);
+        rasterize(RASTER_ENGINE_REFERENCE, &lines, 1, &expected_sink, &frame_arena);
+        
+        for (s32 run = 0; run < (RASTER_ENGINE_COUNT - 1) * (s32) ARRAY_LEN(kernel_variants); ++run) {
+            // @Note: Every engine other than the reference, under every kernel variant the CPU has.
+            s32 engine = RASTER_ENGINE_REFERENCE + 1 + run / (s32) ARRAY_LEN(kernel_variants);
+            kernels = kernel_variants[run % (s32) ARRAY_LEN(kernel_variants)];
+            if (!raster_kernels_supported(kernels)) continue;
+            
+            Span_Sink got_sink = span_sink_mask(&got);
+            rasterize((Raster_Engine) engine, &lines, 1, &got_sink, &frame_arena);
+
+            s32 x, y;
+            if (!coverage_mask_first_difference(&expected, &got, &x, &y)) continue;
+
+            // @Note: The reference goes through floats, say what the exact test thinks so it's
+            // clear which side is off when the sample is right on an edge.
+            u32 exact = 0;
+            for (size_t i = 0; i < lines.size; ++i) {
+                if (ray_hits_line_fixed(lines.data[i], cell_sample(x), cell_sample(y))) exact += 1;
+            }
+            
+            fprintf(stderr, "[ERROR]: '%s' engine with '%s' kernels differs from reference on %s shape #%u (seed %llu)\n",
+                    raster_engine_names[engine], kernels->name, diff_shape_names[shape], index, (unsigned long long) seed);
+            fprintf(stderr, "[ERROR]: First mismatch at cell (%d, %d), reference %d, '%s' %d, exact test %d\n", x, y,
+                    coverage_mask_is_filled(&expected, x, y), raster_engine_names[engine], coverage_mask_is_filled(&got, x, y), exact % 2);
+            fprintf(stderr, "[ERROR]: Vertices (24.8 fixed point):");
+            for (size_t i = 0; i < lines.size; ++i) fprintf(stderr, " (%d, %d)", lines.data[i].x0, lines.data[i].y0);
+            fprintf(stderr, "\n");
+
+            mismatches = 1;
+            break;
+        }
+
+        if (mismatches) break;
+
+        s32 x, y;
+        const char *sink = diff_check_sinks(&lines, &expected, &x, &y);
+        if (sink) {
+            fprintf(stderr, "[ERROR]: '%s' sink differs from the mask sink on %s shape #%u (seed %llu), first at cell (%d, %d)\n",
+                    sink, diff_shape_names[shape], index, (unsigned long long) seed, x, y);
+            mismatches = 1;
+            break;
+        }
+
+        const Raster_Kernels *variant;
+        const char *kernel = diff_check_kernels(&kernel_series, &variant);
+        if (kernel) {
+            fprintf(stderr, "[ERROR]: '%s' kernels' %s differs from the scalar one in round %u (seed %llu)\n",
+                    variant->name, kernel, index, (unsigned long long) seed);
+            mismatches = 1;
+            break;
+        }
+    }
+
+    kernels = selected;
+    line_array_free(&lines);
+    if (mismatches) return(mismatches);
+
+    printf("[INFO]: %u shapes, every engine, kernel variant and span sink matches the reference (seed %llu)\n", count, (unsigned long long) seed);
+    for (s32 shape = 0; shape < DIFF_SHAPE_COUNT; ++shape) {
+        printf("[INFO]:   %-18s %u\n", diff_shape_names[shape], shapes_per_kind[shape]);
+    }
+    
+    return(0);
+}
+
+#define GOLDEN_MAGIC 0x444C4744 // 'DGLD'
+#define GOLDEN_VERSION 1
+
+// @Note: Coverage of every replayed frame, either being written out the first time a recording
+// is replayed or compared against on later runs.
+struct Golden {
+    FILE *file;
+    bool writing;
+    bool failed;
+};
+
+internal void golden_open(Golden *golden, const char *path)
+{
+    *golden = {};
+    u8 header[16];
+    
+    golden->file = fopen(path, "rb");
+    if (golden->file) {
+        bool valid = fread(header, sizeof(header), 1, golden->file) == 1 &&
+            read_u32_le(header + 0) == GOLDEN_MAGIC &&
+            read_u32_le(header + 4) == GOLDEN_VERSION &&
+            read_u32_le(header + 8) == RECT_ROWS &&
+            read_u32_le(header + 12) == RECT_COLS;
+        ERROR_EXIT(!valid, "[ERROR]: '%s' doesn't hold golden masks for a %dx%d grid\n", path, RECT_ROWS, RECT_COLS);
+        
+        printf("[INFO]: Comparing against golden masks in '%s'\n", path);
+        return;
+    }
+
+    golden->file = fopen(path, "wb");
+    ERROR_EXIT(golden->file == 0, "[ERROR]: Could not open '%s' for writing\n", path);
+    golden->writing = true;
+
+    write_u32_le(header + 0, GOLDEN_MAGIC);
+    write_u32_le(header + 4, GOLDEN_VERSION);
+    write_u32_le(header + 8, RECT_ROWS);
+    write_u32_le(header + 12, RECT_COLS);
+    fwrite(header, sizeof(header), 1, golden->file);
+    
+    printf("[INFO]: Writing golden masks to '%s'\n", path);
+}
+
+// @Note: Returns false on the first frame that doesn't match, later frames aren't checked.
+internal bool golden_frame(Golden *golden, u32 frame, Coverage_Mask *mask)
+{
+    u8 data[sizeof(mask->words)];
+
+    if (golden->writing) {
+        for (size_t i = 0; i < ARRAY_LEN(mask->words); ++i) {
+            write_u32_le(data + 8*i, (u32) mask->words[i]);
+            write_u32_le(data + 8*i + 4, (u32) (mask->words[i] >> 32));
+        }
+        
+        fwrite(data, sizeof(data), 1, golden->file);
+        return(true);
+    }
+
+    if (golden->failed) return(false);
+    
+    if (fread(data, sizeof(data), 1, golden->file) != 1) {
+        fprintf(stderr, "[ERROR]: Golden masks end before frame %u\n", frame);
+        golden->failed = true;
+        return(false);
+    }
+
+    static Coverage_Mask expected;
+    for (size_t i = 0; i < ARRAY_LEN(expected.words); ++i) {
+        expected.words[i] = (u64) read_u32_le(data + 8*i) | ((u64) read_u32_le(data + 8*i + 4) << 32);
+    }
+
+    s32 x, y;
+    if (coverage_mask_first_difference(&expected, mask, &x, &y)) {
+        fprintf(stderr, "[ERROR]: Frame %u differs from the golden mask, first at cell (%d, %d)\n", frame, x, y);
+        golden->failed = true;
+        return(false);
+    }
+
+    return(true);
+}
+
+internal f64 elapsed_ms(u64 start, u64 end)
+{
+    return((f64) (end - start) * 1000.0 / (f64) SDL_GetPerformanceFrequency());
+}
+
+enum Perf_Counter {
+    PERF_COUNTER_CYCLES = 0,
+    PERF_COUNTER_INSTRUCTIONS,
+    PERF_COUNTER_L1D_MISSES,
+    PERF_COUNTER_LLC_MISSES,
+    PERF_COUNTER_BRANCH_MISSES,
+    PERF_COUNTER_COUNT,
+};
+
+global const char *perf_counter_names[PERF_COUNTER_COUNT] = {
+    "cycles",
+    "instructions",
+    "L1d misses",
+    "LLC misses",
+    "branch misses",
+};
+
+// @Note: Hardware counters of the calling thread, only on Linux through 'perf_event_open'.
+// Every counter is opened on its own so one the machine doesn't have (common in VMs) doesn't
+// take the others down with it, 'fds' is -1 for those.
+struct Perf_Counters {
+    int fds[PERF_COUNTER_COUNT];
+    u64 values[PERF_COUNTER_COUNT];
+    bool available;
+};
+
+#ifdef __linux__
+internal void perf_counters_open(Perf_Counters *counters)
+{
+    const u32 types[PERF_COUNTER_COUNT] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+    };
+    const u64 configs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    *counters = {};
+    for (s32 i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = types[i];
+        attr.config = configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        counters->fds[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (counters->fds[i] >= 0) counters->available = true;
+    }
+}
+
+internal void perf_counters_close(Perf_Counters *counters)
+{
+    for (s32 i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (counters->fds[i] >= 0) close(counters->fds[i]);
+    }
+}
+
+internal void perf_counters_start(Perf_Counters *counters)
+{
+    for (s32 i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (counters->fds[i] < 0) continue;
+        ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+internal void perf_counters_stop(Perf_Counters *counters)
+{
+    for (s32 i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        counters->values[i] = 0;
+        if (counters->fds[i] < 0) continue;
+        
+        ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counters->fds[i], &counters->values[i], sizeof(u64)) != sizeof(u64)) counters->values[i] = 0;
+    }
+}
+#else
+internal void perf_counters_open(Perf_Counters *counters)
+{
+    *counters = {};
+    for (s32 i = 0; i < PERF_COUNTER_COUNT; ++i) counters->fds[i] = -1;
+}
+
+internal void perf_counters_close(Perf_Counters *counters) { UNUSED(counters); }
+internal void perf_counters_start(Perf_Counters *counters) { UNUSED(counters); }
+internal void perf_counters_stop(Perf_Counters *counters) { UNUSED(counters); }
+#endif
+
+// @Note: Rasterizes the scene 'runs' times with every engine (and the preview) straight into a
+// mask and reports the time per run and per cell of the grid. With 'counters' every engine's
+// runs are also wrapped in hardware counters, when the kernel doesn't let us have them
+// (see /proc/sys/kernel/perf_event_paranoid) we say so and only report times.
+internal void run_benchmark(Line_Array *lines, u32 runs, bool counters)
+{
+    static Coverage_Mask mask;
+    const f64 cells = (f64) RECT_ROWS * RECT_COLS;
+    
+    Perf_Counters perf = {};
+    if (counters) {
+        perf_counters_open(&perf);
+        if (!perf.available) {
+            printf("[INFO]: Hardware counters aren't available here, only reporting times\n");
+            counters = false;
+        }
+    }
+
+    printf("[INFO]: %zu lines, %u runs per engine, '%s' kernels\n", lines->size, runs, kernels->name);
+
+    for (s32 engine = 0; engine <= RASTER_ENGINE_COUNT; ++engine) {
+        // @Note: One past the engines is the drag preview.
+        bool preview = engine == RASTER_ENGINE_COUNT;
+        s32 coarse = preview ? PREVIEW_FACTOR : 1;
+        const char *name = preview ? "preview" : raster_engine_names[engine];
+        Raster_Engine raster_engine = preview ? RASTER_ENGINE_TILED : (Raster_Engine) engine;
+
+        // @Note: The warm-up run also gets the arena to its size, the reset merges its blocks.
+        Span_Sink sink = span_sink_mask(&mask);
+        rasterize(raster_engine, lines, coarse, &sink, &frame_arena);
+        arena_reset(&frame_arena);
+        
+        if (counters) perf_counters_start(&perf);
+        u64 start = SDL_GetPerformanceCounter();
+        
+        for (u32 run = 0; run < runs; ++run) rasterize(raster_engine, lines, coarse, &sink, &frame_arena);
+        
+        u64 end = SDL_GetPerformanceCounter();
+        if (counters) perf_counters_stop(&perf);
+
+        f64 ns_per_run = elapsed_ms(start, end) * 1000000.0 / runs;
+        printf("[INFO]: %-10s %12.1f ns/run %9.2f ns/cell", name, ns_per_run, ns_per_run / cells);
+
+        if (counters) {
+            f64 total_cells = cells * runs;
+            if (perf.fds[PERF_COUNTER_CYCLES] >= 0 && perf.fds[PERF_COUNTER_INSTRUCTIONS] >= 0 && perf.values[PERF_COUNTER_CYCLES] > 0) {
+                printf(" | IPC %.2f", (f64) perf.values[PERF_COUNTER_INSTRUCTIONS] / (f64) perf.values[PERF_COUNTER_CYCLES]);
+            }
+            
+            for (s32 i = 0; i < PERF_COUNTER_COUNT; ++i) {
+                if (perf.fds[i] < 0) continue;
+                printf(" | %s/cell %.3f", perf_counter_names[i], (f64) perf.values[i] / total_cells);
+            }
+        }
+        
+        printf("\n");
+    }
+
+    if (counters) {
+        for (s32 i = 0; i < PERF_COUNTER_COUNT; ++i) {
+            if (perf.fds[i] < 0) printf("[INFO]: No '%s' counter on this machine\n", perf_counter_names[i]);
+        }
+    }
+
+    printf("[INFO]: Scratch high water %zu bytes\n", frame_arena.high_water);
+    auto_engine_report();
+    
+    perf_counters_close(&perf);
+}
+
+internal bool path_has_extension(const char *path, const char *extension)
+{
+    size_t length = strlen(path);
+    size_t extension_length = strlen(extension);
+    return(length >= extension_length && SDL_strcasecmp(path + length - extension_length, extension) == 0);
+}
+
+enum Import_Format {
+    IMPORT_NONE,
+    IMPORT_SVG,
+    IMPORT_GEOJSON,
+    IMPORT_WKT,
+};
+
+internal Import_Format import_format(const char *path)
+{
+    if (path_has_extension(path, ".svg")) return(IMPORT_SVG);
+    if (path_has_extension(path, ".geojson") || path_has_extension(path, ".json")) return(IMPORT_GEOJSON);
+    if (path_has_extension(path, ".wkt")) return(IMPORT_WKT);
+    return(IMPORT_NONE);
+}
+
+// @Note: Replaces 'lines' with what the importer for the file's extension makes of it. Imports
+// 'runs' times when benchmarking and reports the fastest, the first run also pays for reading
+// the file in. SVG gets mapped, the geographic formats are streamed through a chunk buffer.
+internal bool import_scene(const char *path, Import_Format format, Line_Array *lines, u32 runs)
+{
+    Scene_Map map = {};
+    FILE *file = 0;
+    char *buffer = 0;
+    if (format == IMPORT_SVG) {
+        if (!scene_map(&map, path)) return(false);
+    } else {
+        file = fopen(path, "rb");
+        if (!file) return(false);
+
+        buffer = (char *) SDL_malloc(GEO_CHUNK_SIZE);
+        ERROR_EXIT(buffer == 0, "[ERROR]: Out of memory for the import buffer\n");
+    }
+
+    Contour_Builder builder = {};
+    f64 view[4] = {};
+    u64 shapes = 0;
+    u64 skipped = 0;
+    u64 size = map.size;
+    f64 best_ms = 0.0;
+
+    for (u32 run = 0; run < MAX(runs, 1); ++run) {
+        builder.points = 0;
+        builder.contours = 0;
+        builder.start = 0;
+
+        u64 start = SDL_GetPerformanceCounter();
+        if (format == IMPORT_SVG) {
+            svg_import(&builder, (const char *) map.memory, map.size, view, &shapes, &skipped);
+        } else {
+            rewind(file);
+            size = geo_import(&builder, file, format == IMPORT_GEOJSON ? GEO_GEOJSON : GEO_WKT, buffer, &shapes, &skipped);
+        }
+        f64 ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+        if (run == 0 || ms < best_ms) best_ms = ms;
+    }
+
+    contour_builder_to_lines(&builder, lines, view);
+
+    printf("[INFO]: Imported %llu shapes (%llu skipped), %zu contours, %zu lines from '%s'\n",
+           (unsigned long long) shapes, (unsigned long long) skipped, builder.contours, lines->size, path);
+    printf("[INFO]: %.1f MB in %.3f ms, %.0f MB/s%s\n", (f64) size / 1e6, best_ms, (f64) size / 1e6 / MAX(best_ms / 1000.0, 1e-9), runs > 1 ? " (best run)" : "");
+
+    size_t contours = builder.contours;
+    contour_builder_free(&builder);
+    if (format == IMPORT_SVG) {
+        scene_unmap(&map);
+    } else {
+        SDL_free(buffer);
+        fclose(file);
+    }
+
+    // @Note: Nothing filled, e.g. only 'fill="none"' paths or only points and lines, isn't a
+    // shape the engines can work with.
+    return(contours > 0);
+}
+
+#define RECORDING_MAGIC 0x43455244 // 'DREC'
+#define RECORDING_VERSION 1
+#define RECORD_SIZE 10
+
+// @Note: Everything in a recording is little endian and fixed size no matter what machine
+// wrote it. A FRAME record starts every frame and carries the frame's time, the events
+// the loop consumed during that frame follow it.
+enum Record_Type {
+    RECORD_FRAME = 0,
+    RECORD_QUIT,
+    RECORD_KEY_DOWN,
+    RECORD_MOUSE_DOWN,
+    RECORD_MOUSE_UP,
+    RECORD_MOUSE_MOTION,
+
+    RECORD_TYPE_COUNT,
+};
+
+struct Record {
+    u8 type;
+    u8 button;
+    s32 a;
+    s32 b;
+};
+
+struct Frame_Timing {
+    u32 frames;
+    f64 raster_ms_total;
+    f64 raster_ms_max;
+    f64 present_ms_total;
+    f64 present_ms_max;
+
+    // @Note: Summed over every frame, 'peak' is the highest of any frame.
+    Alloc_Frame allocs;
+    u64 allocations_max;
+};
+
+// @Note: Fails a replay that allocates on a frame where a vertex is being dragged, once the
+// first 'warmup_frames' are behind it. By then every buffer should have grown to its size.
+struct Alloc_Check {
+    u32 warmup_frames;
+    u32 failed_frames;
+};
+
+#define DEFLATE_WINDOW 32768
+#define DEFLATE_HASH_BITS 15
+#define DEFLATE_CHAIN_MAX 32
+#define DEFLATE_MIN_MATCH 3
+#define DEFLATE_MAX_MATCH 258
+#define DEFLATE_OUT_MAX (4 * DEFLATE_WINDOW)
+
+// @Note: Deflate (RFC 1951) in a zlib stream (RFC 1950) for PNG, so exporting doesn't need
+// another library. Greedy LZ77 over a 32K window with hash chains and the fixed Huffman codes.
+// It won't beat zlib at level 9, but coverage is mostly long runs of the same bytes and
+// matches take care of those. Input gets pushed in whatever pieces it comes in, the
+// compressed bytes pile up in 'out' until the owner takes them.
+struct Deflate {
+    u8 window[2 * DEFLATE_WINDOW];
+    s32 head[1 << DEFLATE_HASH_BITS];
+    s32 prev[DEFLATE_WINDOW];
+    s32 size;
+    s32 at;
+
+    u64 bits;
+    u32 bit_count;
+    u8 out[DEFLATE_OUT_MAX];
+    size_t out_size;
+
+    u32 adler_a;
+    u32 adler_b;
+};
+
+global const s32 deflate_length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+global const u8 deflate_length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+global const s32 deflate_distance_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+                                              4097, 6145, 8193, 12289, 16385, 24577};
+global const u8 deflate_distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+internal void deflate_bits(Deflate *deflate, u32 value, u32 count)
+{
+    deflate->bits |= (u64) value << deflate->bit_count;
+    deflate->bit_count += count;
+    while (deflate->bit_count >= 8) {
+        deflate->out[deflate->out_size++] = (u8) deflate->bits;
+        deflate->bits >>= 8;
+        deflate->bit_count -= 8;
+    }
+}
+
+// @Note: Huffman codes go out starting from their most significant bit, everything else
+// from the least significant one.
+internal void deflate_code(Deflate *deflate, u32 code, u32 length)
+{
+    u32 reversed = 0;
+    for (u32 i = 0; i < length; ++i) reversed |= ((code >> i) & 1) << (length - 1 - i);
+    deflate_bits(deflate, reversed, length);
+}
+
+internal void deflate_literal(Deflate *deflate, u32 symbol)
+{
+    if (symbol < 144) deflate_code(deflate, 0x30 + symbol, 8);
+    else if (symbol < 256) deflate_code(deflate, 0x190 + symbol - 144, 9);
+    else if (symbol < 280) deflate_code(deflate, symbol - 256, 7);
+    else deflate_code(deflate, 0xC0 + symbol - 280, 8);
+}
+
+internal void deflate_match(Deflate *deflate, s32 length, s32 distance)
+{
+    s32 code = (s32) ARRAY_LEN(deflate_length_base) - 1;
+    while (deflate_length_base[code] > length) code -= 1;
+    deflate_literal(deflate, 257 + code);
+    deflate_bits(deflate, (u32) (length - deflate_length_base[code]), deflate_length_extra[code]);
+
+    code = (s32) ARRAY_LEN(deflate_distance_base) - 1;
+    while (deflate_distance_base[code] > distance) code -= 1;
+    deflate_code(deflate, (u32) code, 5);
+    deflate_bits(deflate, (u32) (distance - deflate_distance_base[code]), deflate_distance_extra[code]);
+}
+
+internal inline u32 deflate_hash(const u8 *at)
+{
+    u32 value = (u32) at[0] | ((u32) at[1] << 8) | ((u32) at[2] << 16);
+    return((value * 2654435761u) >> (32 - DEFLATE_HASH_BITS));
+}
+
+internal void deflate_init(Deflate *deflate)
+{
+    memset(deflate->head, 0xFF, sizeof(deflate->head));
+    memset(deflate->prev, 0xFF, sizeof(deflate->prev));
+    deflate->size = 0;
+    deflate->at = 0;
+    deflate->bits = 0;
+    deflate->bit_count = 0;
+    deflate->adler_a = 1;
+    deflate->adler_b = 0;
+
+    // @Note: The zlib header says deflate with a 32K window. Everything goes into one block with
+    // the fixed codes, it isn't the final one since we don't know yet where the input ends.
+    deflate->out[0] = 0x78;
+    deflate->out[1] = 0x01;
+    deflate->out_size = 2;
+    deflate_bits(deflate, 0, 1);
+    deflate_bits(deflate, 1, 2);
+}
+
+// @Note: Leaves the last DEFLATE_MAX_MATCH bytes alone unless 'finish', more input might
+// still make them part of a longer match.
+internal void deflate_compress(Deflate *deflate, bool finish)
+{
+    u8 *window = deflate->window;
+    s32 limit = finish ? deflate->size : deflate->size - DEFLATE_MAX_MATCH;
+
+    while (deflate->at < limit) {
+        s32 at = deflate->at;
+        s32 available = MIN(deflate->size - at, DEFLATE_MAX_MATCH);
+        s32 best_length = 0;
+        s32 best_distance = 0;
+
+        if (available >= DEFLATE_MIN_MATCH) {
+            s32 candidate = deflate->head[deflate_hash(&window[at])];
+            for (s32 chain = 0; chain < DEFLATE_CHAIN_MAX && candidate >= 0 && at - candidate <= DEFLATE_WINDOW; ++chain) {
+                s32 length = 0;
+                while (length < available && window[candidate + length] == window[at + length]) length += 1;
+
+                if (length > best_length) {
+                    best_length = length;
+                    best_distance = at - candidate;
+                    if (length == available) break;
+                }
+
+                candidate = deflate->prev[candidate & (DEFLATE_WINDOW - 1)];
+            }
+        }
+
+        s32 advance = 1;
+        if (best_length >= DEFLATE_MIN_MATCH) {
+            deflate_match(deflate, best_length, best_distance);
+            advance = best_length;
+        } else {
+            deflate_literal(deflate, window[at]);
+        }
+
+        for (s32 i = at; i < at + advance && i + DEFLATE_MIN_MATCH <= deflate->size; ++i) {
+            u32 hash = deflate_hash(&window[i]);
+            deflate->prev[i & (DEFLATE_WINDOW - 1)] = deflate->head[hash];
+            deflate->head[hash] = i;
+        }
+
+        deflate->at = at + advance;
+    }
+}
+
+// @Note: Takes as much of 'data' as fits the window and compresses what it can, returns how
+// much it took. Whatever a push adds to 'out' stays below 1.2x of what it took.
+internal size_t deflate_push(Deflate *deflate, const u8 *data, size_t size)
+{
+    if (deflate->size == 2 * DEFLATE_WINDOW) {
+        // @Note: Everything before 'at' is only history, one window of it is all matches can use.
+        memmove(deflate->window, deflate->window + DEFLATE_WINDOW, DEFLATE_WINDOW);
+        deflate->size -= DEFLATE_WINDOW;
+        deflate->at -= DEFLATE_WINDOW;
+
+        for (size_t i = 0; i < ARRAY_LEN(deflate->head); ++i) deflate->head[i] = deflate->head[i] >= DEFLATE_WINDOW ? deflate->head[i] - DEFLATE_WINDOW : -1;
+        for (size_t i = 0; i < ARRAY_LEN(deflate->prev); ++i) deflate->prev[i] = deflate->prev[i] >= DEFLATE_WINDOW ? deflate->prev[i] - DEFLATE_WINDOW : -1;
+    }
+
+    size_t taken = MIN(size, (size_t) (2 * DEFLATE_WINDOW - deflate->size));
+    memcpy(deflate->window + deflate->size, data, taken);
+    deflate->size += (s32) taken;
+
+    // @Note: 5552 bytes is as many as the sums can take before they'd overflow.
+    u32 a = deflate->adler_a;
+    u32 b = deflate->adler_b;
+    for (size_t i = 0; i < taken;) {
+        size_t end = MIN(taken, i + 5552);
+        for (; i < end; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    deflate->adler_a = a;
+    deflate->adler_b = b;
+
+    deflate_compress(deflate, false);
+    return(taken);
+}
+
+internal void deflate_finish(Deflate *deflate)
+{
+    deflate_compress(deflate, true);
+    deflate_literal(deflate, 256);
+
+    // @Note: An empty final block, the one above didn't know it would be the last.
+    deflate_bits(deflate, 1, 1);
+    deflate_bits(deflate, 1, 2);
+    deflate_literal(deflate, 256);
+    if (deflate->bit_count > 0) deflate_bits(deflate, 0, 8 - deflate->bit_count);
+
+    write_u32_be(deflate->out + deflate->out_size, (deflate->adler_b << 16) | deflate->adler_a);
+    deflate->out_size += 4;
+}
+
+#define PNG_IDAT_SIZE (32 * 1024)
+
+global u32 png_crc_table[256];
+
+internal void png_crc_init(void)
+{
+    for (u32 i = 0; i < 256; ++i) {
+        u32 crc = i;
+        for (s32 bit = 0; bit < 8; ++bit) crc = (crc & 1) ? 0xEDB88320u ^ (crc >> 1) : crc >> 1;
+        png_crc_table[i] = crc;
+    }
+}
+
+internal u32 png_crc(u32 crc, const u8 *data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) crc = png_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return(crc);
+}
+
+internal bool png_chunk(FILE *file, const char *type, const u8 *data, size_t size)
+{
+    u8 header[8];
+    write_u32_be(header, (u32) size);
+    memcpy(header + 4, type, 4);
+
+    u8 footer[4];
+    write_u32_be(footer, png_crc(png_crc(0xFFFFFFFFu, header + 4, 4), data, size) ^ 0xFFFFFFFFu);
+
+    return(fwrite(header, sizeof(header), 1, file) == 1 && (size == 0 || fwrite(data, size, 1, file) == 1) &&
+           fwrite(footer, sizeof(footer), 1, file) == 1);
+}
+
+// @Note: Whatever the deflate stream has, as IDAT chunks of PNG_IDAT_SIZE. 'all' also writes
+// the last partial one.
+internal bool png_flush(FILE *file, Deflate *deflate, bool all)
+{
+    size_t written = 0;
+    bool ok = true;
+    while (ok && (deflate->out_size - written >= PNG_IDAT_SIZE || (all && written < deflate->out_size))) {
+        size_t size = MIN(deflate->out_size - written, (size_t) PNG_IDAT_SIZE);
+        ok = png_chunk(file, "IDAT", deflate->out + written, size);
+        written += size;
+    }
+
+    memmove(deflate->out, deflate->out + written, deflate->out_size - written);
+    deflate->out_size -= written;
+    return(ok);
+}
+
+#define EXPORT_QUEUE_MAX 4
+#define EXPORT_PATH_MAX 256
+#define EXPORT_AA_SAMPLES 4
+// @Note: What 'render_frame' clears to, PPM has no alpha so the colour gets blended over it.
+#define EXPORT_BACKGROUND 18
+
+enum Export_Format {
+    EXPORT_FORMAT_NONE = 0,
+    EXPORT_FORMAT_PGM,
+    EXPORT_FORMAT_PPM,
+    EXPORT_FORMAT_PNG,
+};
+
+// @Note: 'mask' is the coverage the engines make, one bit per cell. 'aa' samples every cell
+// EXPORT_AA_SAMPLES^2 times for 8-bit coverage. 'rgba' is the 'aa' coverage as the alpha of
+// the scene colour.
+enum Export_Mode {
+    EXPORT_MODE_MASK = 0,
+    EXPORT_MODE_AA,
+    EXPORT_MODE_RGBA,
+    EXPORT_MODE_COUNT,
+};
+
+global const char *export_mode_names[EXPORT_MODE_COUNT] = {
+    "mask",
+    "aa",
+    "rgba",
+};
+
+struct Export_Job {
+    char path[EXPORT_PATH_MAX];
+    Export_Format format;
+    Export_Mode mode;
+    s32 scale;
+    u32 color;
+    Raster_Engine engine;
+    Line_Array lines;
+};
+
+// @Note: Rasterizes and encodes exports on its own thread so the frame that asked for one
+// doesn't wait on the disk. Jobs stay in their slot until they are written, 'head' is the
+// one the writer is on. The UI thread only fills free slots, so it can copy the lines in
+// without holding the lock.
+struct Export_Writer {
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *not_empty;
+    Export_Job jobs[EXPORT_QUEUE_MAX];
+    u32 head;
+    u32 count;
+    bool quit;
+
+    // @Note: Writer thread only.
+    Arena arena;
+    Line_Array shifted;
+    Coverage_Mask mask;
+    Deflate *deflate;
+    u32 failed;
+
+    // @Note: What new jobs get.
+    Export_Mode mode;
+    s32 scale;
+    u32 color;
+    u32 submitted;
+};
+
+internal Export_Format export_format(const char *path)
+{
+    if (path_has_extension(path, ".pgm")) return(EXPORT_FORMAT_PGM);
+    if (path_has_extension(path, ".ppm")) return(EXPORT_FORMAT_PPM);
+    if (path_has_extension(path, ".png")) return(EXPORT_FORMAT_PNG);
+    return(EXPORT_FORMAT_NONE);
+}
+
+// @Note: Coverage of every cell from 0 to 255. The sub-samples come from rasterizing the shape
+// shifted by fractions of a cell, so every engine can do it and the cell centres stay where
+// the engines have them.
+internal void export_coverage(Export_Writer *writer, Export_Job *job, u8 *levels)
+{
+    if (job->mode == EXPORT_MODE_MASK) {
+        Span_Sink sink = span_sink_mask(&writer->mask);
+        rasterize(job->engine, &job->lines, 1, &sink, &writer->arena);
+
+        for (s32 y = 0; y < RECT_COLS; ++y) {
+            for (s32 x = 0; x < RECT_ROWS; ++x) levels[y * RECT_ROWS + x] = ((MASK_AT(writer->mask.words, x, y) >> (x % 64)) & 1) ? 255 : 0;
+        }
+        return;
+    }
+
+    memset(levels, 0, RECT_ROWS * RECT_COLS);
+    line_array_copy(&writer->shifted, &job->lines);
+
+    for (s32 sy = 0; sy < EXPORT_AA_SAMPLES; ++sy) {
+        for (s32 sx = 0; sx < EXPORT_AA_SAMPLES; ++sx) {
+            s32 dx = FIXED_ONE * (2 * sx + 1 - EXPORT_AA_SAMPLES) / (2 * EXPORT_AA_SAMPLES);
+            s32 dy = FIXED_ONE * (2 * sy + 1 - EXPORT_AA_SAMPLES) / (2 * EXPORT_AA_SAMPLES);
+            for (size_t i = 0; i < job->lines.size; ++i) {
+                Line *from = &job->lines.data[i];
+                Line *to = &writer->shifted.data[i];
+                to->x0 = from->x0 - dx;
+                to->y0 = from->y0 - dy;
+                to->x1 = from->x1 - dx;
+                to->y1 = from->y1 - dy;
+            }
+
+            Arena_Temp temp = arena_begin_temp(&writer->arena);
+            Span_Sink sink = span_sink_mask(&writer->mask);
+            rasterize(job->engine, &writer->shifted, 1, &sink, &writer->arena);
+            arena_end_temp(temp);
+
+            for (s32 y = 0; y < RECT_COLS; ++y) {
+                for (s32 x = 0; x < RECT_ROWS; ++x) levels[y * RECT_ROWS + x] += (u8) ((MASK_AT(writer->mask.words, x, y) >> (x % 64)) & 1);
+            }
+        }
+    }
+
+    for (s32 i = 0; i < RECT_ROWS * RECT_COLS; ++i) levels[i] = (u8) (levels[i] * 255 / (EXPORT_AA_SAMPLES * EXPORT_AA_SAMPLES));
+}
+
+// @Note: Every cell becomes 'scale' by 'scale' pixels. Rows get made and written out one at a
+// time, the whole image never exists in memory: PNG rows go through the Up filter and into
+// the deflate stream, which goes out in IDAT chunks as they fill up.
+internal bool export_image(Export_Writer *writer, Export_Job *job)
+{
+    FILE *file = fopen(job->path, "wb");
+    if (!file) return(false);
+
+    u8 *levels = ARENA_PUSH_ARRAY(&writer->arena, u8, RECT_ROWS * RECT_COLS);
+    export_coverage(writer, job, levels);
+
+    s32 width = RECT_ROWS * job->scale;
+    s32 height = RECT_COLS * job->scale;
+    bool one_bit = job->format == EXPORT_FORMAT_PNG && job->mode == EXPORT_MODE_MASK;
+    s32 channels = 1;
+    if (job->format == EXPORT_FORMAT_PPM) channels = 3;
+    else if (job->format == EXPORT_FORMAT_PNG && job->mode == EXPORT_MODE_RGBA) channels = 4;
+    size_t row_size = one_bit ? (size_t) (width + 7) / 8 : (size_t) width * channels;
+
+    // @Note: One extra byte in front for the PNG filter type.
+    u8 *row = ARENA_PUSH_ARRAY(&writer->arena, u8, row_size + 1);
+    u8 *previous = ARENA_PUSH_ARRAY(&writer->arena, u8, row_size + 1);
+    u8 *filtered = ARENA_PUSH_ARRAY(&writer->arena, u8, row_size + 1);
+    memset(previous, 0, row_size + 1);
+
+    bool ok = true;
+    if (job->format == EXPORT_FORMAT_PNG) {
+        static const u8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        u8 header[13];
+        write_u32_be(header, (u32) width);
+        write_u32_be(header + 4, (u32) height);
+        header[8] = one_bit ? 1 : 8;
+        header[9] = channels == 4 ? 6 : 0;
+        header[10] = 0;
+        header[11] = 0;
+        header[12] = 0;
+
+        ok = fwrite(signature, sizeof(signature), 1, file) == 1 && png_chunk(file, "IHDR", header, sizeof(header));
+        deflate_init(writer->deflate);
+    } else {
+        ok = fprintf(file, "%s\n%d %d\n255\n", channels == 3 ? "P6" : "P5", width, height) > 0;
+    }
+
+    u32 alpha = job->color >> 24;
+    s32 color[3] = {(s32) ((job->color >> 16) & 0xFF), (s32) ((job->color >> 8) & 0xFF), (s32) (job->color & 0xFF)};
+
+    for (s32 y = 0; y < RECT_COLS && ok; ++y) {
+        u8 *pixels = row + 1;
+        const u8 *cells = &levels[y * RECT_ROWS];
+        if (one_bit) memset(pixels, 0, row_size);
+
+        for (s32 x = 0; x < width; ++x) {
+            u32 level = cells[x / job->scale];
+            if (one_bit) {
+                if (level >= 128) pixels[x / 8] |= (u8) (0x80 >> (x % 8));
+            } else if (channels == 1) {
+                pixels[x] = (u8) level;
+            } else {
+                s32 coverage = (s32) ((alpha * level + 127) / 255);
+                u8 *pixel = &pixels[x * channels];
+                if (channels == 4) {
+                    pixel[0] = (u8) color[0];
+                    pixel[1] = (u8) color[1];
+                    pixel[2] = (u8) color[2];
+                    pixel[3] = (u8) coverage;
+                } else {
+                    for (s32 c = 0; c < 3; ++c) pixel[c] = (u8) (EXPORT_BACKGROUND + (color[c] - EXPORT_BACKGROUND) * coverage / 255);
+                }
+            }
+        }
+
+        for (s32 repeat = 0; repeat < job->scale && ok; ++repeat) {
+            if (job->format != EXPORT_FORMAT_PNG) {
+                ok = fwrite(pixels, row_size, 1, file) == 1;
+                continue;
+            }
+
+            // @Note: Up filter, the rows a cell repeats into become all zeros.
+            filtered[0] = 2;
+            for (size_t i = 1; i <= row_size; ++i) filtered[i] = (u8) (row[i] - previous[i]);
+            memcpy(previous, row, row_size + 1);
+
+            size_t pushed = 0;
+            while (pushed < row_size + 1 && ok) {
+                pushed += deflate_push(writer->deflate, filtered + pushed, row_size + 1 - pushed);
+                ok = png_flush(file, writer->deflate, false);
+            }
+        }
+    }
+
+    if (ok && job->format == EXPORT_FORMAT_PNG) {
+        deflate_finish(writer->deflate);
+        ok = png_flush(file, writer->deflate, true) && png_chunk(file, "IEND", 0, 0);
+    }
+
+    if (fclose(file) != 0) ok = false;
+    return(ok);
+}
+
+internal int export_writer_thread(void *data)
+{
+    Export_Writer *writer = (Export_Writer *) data;
+    alloc_phase = ALLOC_PHASE_WORKER;
+
+    for (;;) {
+        SDL_LockMutex(writer->lock);
+        while (writer->count == 0 && !writer->quit) SDL_CondWait(writer->not_empty, writer->lock);
+        Export_Job *job = writer->count > 0 ? &writer->jobs[writer->head] : 0;
+        SDL_UnlockMutex(writer->lock);
+
+        if (!job) break;
+
+        arena_reset(&writer->arena);
+        u64 start = SDL_GetPerformanceCounter();
+        if (export_image(writer, job)) {
+            printf("[INFO]: Exported '%s' (%dx%d, %s) in %.3f ms\n", job->path, RECT_ROWS * job->scale, RECT_COLS * job->scale,
+                   export_mode_names[job->mode], elapsed_ms(start, SDL_GetPerformanceCounter()));
+        } else {
+            fprintf(stderr, "[ERROR]: Could not write '%s'\n", job->path);
+            writer->failed += 1;
+        }
+
+        SDL_LockMutex(writer->lock);
+        writer->head = (writer->head + 1) % EXPORT_QUEUE_MAX;
+        writer->count -= 1;
+        SDL_UnlockMutex(writer->lock);
+    }
+
+    return(0);
+}
+
+internal void export_writer_start(Export_Writer *writer, Export_Mode mode, s32 scale, u32 color)
+{
+    png_crc_init();
+
+    writer->head = 0;
+    writer->count = 0;
+    writer->quit = false;
+    writer->arena = {};
+    writer->arena.name = "export";
+    writer->failed = 0;
+    writer->mode = mode;
+    writer->scale = MAX(scale, 1);
+    writer->color = color;
+    writer->submitted = 0;
+
+    writer->deflate = (Deflate *) SDL_malloc(sizeof(Deflate));
+    ERROR_EXIT(writer->deflate == 0, "[ERROR]: Out of memory for the export encoder\n");
+
+    writer->lock = SDL_CreateMutex();
+    writer->not_empty = SDL_CreateCond();
+    ERROR_EXIT(writer->lock == 0 || writer->not_empty == 0, "[ERROR]: Could not create the export queue -> %s\n", SDL_GetError());
+
+    writer->thread = SDL_CreateThread(export_writer_thread, "raster_export", writer);
+    ERROR_EXIT(writer->thread == 0, "[ERROR]: Could not create export writer -> %s\n", SDL_GetError());
+}
+
+// @Note: Writes whatever is still queued before it returns.
+internal void export_writer_stop(Export_Writer *writer)
+{
+    SDL_LockMutex(writer->lock);
+    writer->quit = true;
+    SDL_CondSignal(writer->not_empty);
+    SDL_UnlockMutex(writer->lock);
+
+    SDL_WaitThread(writer->thread, 0);
+    SDL_DestroyCond(writer->not_empty);
+    SDL_DestroyMutex(writer->lock);
+
+    for (size_t i = 0; i < ARRAY_LEN(writer->jobs); ++i) line_array_free(&writer->jobs[i].lines);
+    line_array_free(&writer->shifted);
+    arena_free(&writer->arena);
+    SDL_free(writer->deflate);
+}
+
+// @Note: Called from the UI thread only, never waits for the writer. When it's that far
+// behind the export gets dropped.
+internal bool export_writer_submit(Export_Writer *writer, Line_Array *lines, Raster_Engine engine, const char *path)
+{
+    SDL_LockMutex(writer->lock);
+    u32 count = writer->count;
+    u32 slot = (writer->head + count) % EXPORT_QUEUE_MAX;
+    SDL_UnlockMutex(writer->lock);
+
+    if (count == EXPORT_QUEUE_MAX) {
+        fprintf(stderr, "[WARNING]: %u exports are still being written, dropped '%s'\n", count, path);
+        return(false);
+    }
+
+    Export_Job *job = &writer->jobs[slot];
+    snprintf(job->path, sizeof(job->path), "%s", path);
+    job->format = export_format(path);
+    job->mode = writer->mode;
+    job->scale = writer->scale;
+    job->color = writer->color;
+    job->engine = engine;
+    line_array_copy(&job->lines, lines);
+    writer->submitted += 1;
+
+    SDL_LockMutex(writer->lock);
+    writer->count += 1;
+    SDL_CondSignal(writer->not_empty);
+    SDL_UnlockMutex(writer->lock);
+
+    return(true);
+}
+
+#define VIDEO_QUEUE_FRAMES 8
+
+// @Note: A converted frame waiting for the writer, 'repeat' is how many video frames it
+// stands for when the session skipped some.
+struct Video_Frame {
+    u8 *planes;
+    u32 repeat;
+};
+
+// @Note: Raw YUV 4:2:0 video (Y4M) of what gets presented. The UI thread reads the frame back
+// before presenting it, converts it with the YUV kernel straight into a free slot of the queue
+// and goes on, the writer thread only writes slots out. Frames follow the session's clock at
+// FPS frames per second: a frame that took longer becomes several video frames, a frame in the
+// same tick as the last one doesn't get captured. Only a full queue makes the UI thread wait,
+// those frames are counted as stalls. Slots stay taken until written, like 'Export_Writer'.
+struct Video_Writer {
+    FILE *file;
+    const char *path;
+    s32 width;
+    s32 height;
+    size_t frame_size;
+
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *not_empty;
+    SDL_cond *not_full;
+    Video_Frame frames[VIDEO_QUEUE_FRAMES];
+    u32 head;
+    u32 count;
+    bool quit;
+
+    // @Note: Writer thread only.
+    u64 bytes;
+    bool failed;
+
+    // @Note: UI thread only.
+    u32 *pixels;
+    bool started;
+    u32 start_ms;
+    u64 emitted;
+    u64 captured;
+    u64 stalls;
+    f64 convert_ms;
+    f64 stall_ms;
+};
+
+internal int video_writer_thread(void *data)
+{
+    Video_Writer *video = (Video_Writer *) data;
+    alloc_phase = ALLOC_PHASE_WORKER;
+
+    for (;;) {
+        SDL_LockMutex(video->lock);
+        while (video->count == 0 && !video->quit) SDL_CondWait(video->not_empty, video->lock);
+        Video_Frame *frame = video->count > 0 ? &video->frames[video->head] : 0;
+        SDL_UnlockMutex(video->lock);
+
+        if (!frame) break;
+
+        for (u32 i = 0; i < frame->repeat && !video->failed; ++i) {
+            if (fwrite("FRAME\n", 6, 1, video->file) != 1 || fwrite(frame->planes, video->frame_size, 1, video->file) != 1) {
+                fprintf(stderr, "[ERROR]: Could not write to '%s', the rest of the video gets dropped\n", video->path);
+                video->failed = true;
+            } else {
+                video->bytes += 6 + video->frame_size;
+            }
+        }
+
+        SDL_LockMutex(video->lock);
+        video->head = (video->head + 1) % VIDEO_QUEUE_FRAMES;
+        video->count -= 1;
+        SDL_CondSignal(video->not_full);
+        SDL_UnlockMutex(video->lock);
+    }
+
+    return(0);
+}
+
+internal void video_open(Video_Writer *video, const char *path, SDL_Renderer *renderer)
+{
+    *video = {};
+    video->path = path;
+    ERROR_EXIT(SDL_GetRendererOutputSize(renderer, &video->width, &video->height) != 0, "[ERROR]: Could not get the renderer size -> %s\n", SDL_GetError());
+    ERROR_EXIT(video->width % 2 != 0 || video->height % 2 != 0, "[ERROR]: 4:2:0 video needs an even size, the window is %dx%d\n", video->width, video->height);
+
+    video->file = fopen(path, "wb");
+    ERROR_EXIT(video->file == 0, "[ERROR]: Could not open '%s' for writing\n", path);
+
+    // @Note: 'C420jpeg' because the chroma is the average of each 2x2 block, its sample sits in
+    // the middle of them.
+    fprintf(video->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", video->width, video->height, FPS);
+
+    size_t pixels = (size_t) video->width * video->height;
+    video->frame_size = pixels + pixels / 2;
+    video->pixels = (u32 *) SDL_malloc(pixels * sizeof(u32));
+    ERROR_EXIT(video->pixels == 0, "[ERROR]: Out of memory for a %dx%d frame\n", video->width, video->height);
+
+    for (u32 i = 0; i < VIDEO_QUEUE_FRAMES; ++i) {
+        video->frames[i].planes = (u8 *) SDL_malloc(video->frame_size);
+        ERROR_EXIT(video->frames[i].planes == 0, "[ERROR]: Out of memory for the video queue\n");
+    }
+
+    video->lock = SDL_CreateMutex();
+    video->not_empty = SDL_CreateCond();
+    video->not_full = SDL_CreateCond();
+    ERROR_EXIT(video->lock == 0 || video->not_empty == 0 || video->not_full == 0, "[ERROR]: Could not create the video queue -> %s\n", SDL_GetError());
+
+    video->thread = SDL_CreateThread(video_writer_thread, "raster_video", video);
+    ERROR_EXIT(video->thread == 0, "[ERROR]: Could not create video writer -> %s\n", SDL_GetError());
+}
+
+// @Note: Called from the UI thread between drawing a frame and presenting it. 'now' is the
+// session's clock in milliseconds, the recorded one during replays.
+internal void video_capture(Video_Writer *video, SDL_Renderer *renderer, u32 now)
+{
+    if (!video->started) {
+        video->started = true;
+        video->start_ms = now;
+    }
+
+    u64 due = (u64) (now - video->start_ms) * FPS / 1000 + 1;
+    if (due <= video->emitted) return;
+
+    SDL_LockMutex(video->lock);
+    u64 stall_start = SDL_GetPerformanceCounter();
+    bool stalled = video->count == VIDEO_QUEUE_FRAMES;
+    while (video->count == VIDEO_QUEUE_FRAMES) SDL_CondWait(video->not_full, video->lock);
+    u32 slot = (video->head + video->count) % VIDEO_QUEUE_FRAMES;
+    SDL_UnlockMutex(video->lock);
+
+    if (stalled) {
+        video->stalls += 1;
+        video->stall_ms += elapsed_ms(stall_start, SDL_GetPerformanceCounter());
+    }
+
+    if (SDL_RenderReadPixels(renderer, 0, SDL_PIXELFORMAT_ARGB8888, video->pixels, video->width * (s32) sizeof(u32)) != 0) {
+        fprintf(stderr, "[WARNING]: Could not read the frame back for the video -> %s\n", SDL_GetError());
+        return;
+    }
+
+    u64 start = SDL_GetPerformanceCounter();
+    Video_Frame *frame = &video->frames[slot];
+    s32 width = video->width;
+    u8 *luma = frame->planes;
+    u8 *u = luma + (size_t) width * video->height;
+    u8 *v = u + (size_t) (width / 2) * (video->height / 2);
+    for (s32 y = 0; y < video->height; y += 2) {
+        const u32 *row = &video->pixels[(size_t) y * width];
+        kernels->yuv420_rows(row, row + width, width, luma + (size_t) y * width, luma + (size_t) (y + 1) * width,
+                             u + (size_t) (y / 2) * (width / 2), v + (size_t) (y / 2) * (width / 2));
+    }
+    video->convert_ms += elapsed_ms(start, SDL_GetPerformanceCounter());
+
+    frame->repeat = (u32) (due - video->emitted);
+    video->emitted = due;
+    video->captured += 1;
+
+    SDL_LockMutex(video->lock);
+    video->count += 1;
+    SDL_CondSignal(video->not_empty);
+    SDL_UnlockMutex(video->lock);
+}
+
+// @Note: Writes whatever is still queued, then reports.
+internal void video_close(Video_Writer *video)
+{
+    SDL_LockMutex(video->lock);
+    video->quit = true;
+    SDL_CondSignal(video->not_empty);
+    SDL_UnlockMutex(video->lock);
+
+    SDL_WaitThread(video->thread, 0);
+    SDL_DestroyCond(video->not_full);
+    SDL_DestroyCond(video->not_empty);
+    SDL_DestroyMutex(video->lock);
+    fclose(video->file);
+
+    printf("[INFO]: Video: %llu frames (%llu repeated) at %dx%d, %.1f MB to '%s'\n", (unsigned long long) video->emitted,
+           (unsigned long long) (video->emitted - video->captured), video->width, video->height, video->bytes / 1e6, video->path);
+    printf("[INFO]: Video: converting took %.3f ms per frame, %llu frames waited %.1f ms in total for a full queue\n",
+           video->captured > 0 ? video->convert_ms / video->captured : 0.0, (unsigned long long) video->stalls, video->stall_ms);
+
+    for (u32 i = 0; i < VIDEO_QUEUE_FRAMES; ++i) SDL_free(video->frames[i].planes);
+    SDL_free(video->pixels);
+}
+
+struct App {
+    Line_Array lines;
+    Raster_Ctx raster;
+    
+    bool should_quit;
+    bool mouse_held;
+    s32 line_index;
+
+    FILE *recording;
+
+    // @Note: What the last frame allocated.
+    Alloc_Frame allocs;
+
+    Export_Writer exporter;
+    Video_Writer *video;
+};
+
+internal void recording_write_header(FILE *file)
+{
+    u8 header[16];
+    write_u32_le(header + 0, RECORDING_MAGIC);
+    write_u32_le(header + 4, RECORDING_VERSION);
+    write_u32_le(header + 8, RECT_ROWS);
+    write_u32_le(header + 12, RECT_COLS);
+    fwrite(header, sizeof(header), 1, file);
+}
+
+// @Note: Returns false if this isn't a recording we can replay on this grid.
+internal bool recording_read_header(FILE *file)
+{
+    u8 header[16];
+    if (fread(header, sizeof(header), 1, file) != 1) return(false);
+
+    return(read_u32_le(header + 0) == RECORDING_MAGIC &&
+           read_u32_le(header + 4) == RECORDING_VERSION &&
+           read_u32_le(header + 8) == RECT_ROWS &&
+           read_u32_le(header + 12) == RECT_COLS);
+}
+
+internal void recording_write(FILE *file, Record record)
+{
+    u8 data[RECORD_SIZE];
+    data[0] = record.type;
+    data[1] = record.button;
+    write_u32_le(data + 2, (u32) record.a);
+    write_u32_le(data + 6, (u32) record.b);
+    fwrite(data, sizeof(data), 1, file);
+}
+
+// @Note: Returns false at the end of the recording and for a record type this build doesn't
+// know, only in the second case the file isn't at its end yet.
+internal bool recording_read(FILE *file, Record *record)
+{
+    u8 data[RECORD_SIZE];
+    if (fread(data, sizeof(data), 1, file) != 1) return(false);
+    
+    record->type = data[0];
+    record->button = data[1];
+    record->a = (s32) read_u32_le(data + 2);
+    record->b = (s32) read_u32_le(data + 6);
+    
+    return(record->type < RECORD_TYPE_COUNT);
+}
+
+// @Note: Only the events the loop actually handles get recorded, returns false for the rest.
+internal bool record_from_event(SDL_Event *e, Record *record)
+{
+    *record = {};
+    
+    switch (e->type) {
+        case SDL_QUIT: record->type = RECORD_QUIT; break;
+        case SDL_KEYDOWN: record->type = RECORD_KEY_DOWN; record->a = e->key.keysym.sym; break;
+        
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP: {
+            record->type = (e->type == SDL_MOUSEBUTTONDOWN) ? RECORD_MOUSE_DOWN : RECORD_MOUSE_UP;
+            record->button = e->button.button;
+            record->a = e->button.x;
+            record->b = e->button.y;
+        } break;
+
+        case SDL_MOUSEMOTION: {
+            record->type = RECORD_MOUSE_MOTION;
+            record->a = e->motion.x;
+            record->b = e->motion.y;
+        } break;
+
+        default: return(false);
+    }
+
+    return(true);
+}
+
+internal SDL_Event event_from_record(Record *record)
+{
+    SDL_Event e = {0};
+    
+    switch (record->type) {
+        case RECORD_QUIT: e.type = SDL_QUIT; break;
+        case RECORD_KEY_DOWN: e.type = SDL_KEYDOWN; e.key.keysym.sym = record->a; break;
+
+        case RECORD_MOUSE_DOWN:
+        case RECORD_MOUSE_UP: {
+            e.type = (record->type == RECORD_MOUSE_DOWN) ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+            e.button.button = record->button;
+            e.button.x = record->a;
+            e.button.y = record->b;
+        } break;
+
+        case RECORD_MOUSE_MOTION: {
+            e.type = SDL_MOUSEMOTION;
+            e.motion.x = record->a;
+            e.motion.y = record->b;
+        } break;
+
+        default: assert(false && "Unknown record type");
+    }
+
+    return(e);
+}
+
+internal void app_handle_event(App *app, SDL_Event *e)
+{
+    Raster_Ctx *raster = &app->raster;
+    Line_Array *lines = &app->lines;
+
+    if (app->recording) {
+        Record record;
+        if (record_from_event(e, &record)) recording_write(app->recording, record);
+    }
+    
+    switch (e->type) {
+        case SDL_QUIT: {
+            app->should_quit = true;
+        } break;
+
+        case SDL_KEYDOWN: {
+            if (e->key.keysym.sym == SDLK_e) {
+                raster->engine = (Raster_Engine) ((raster->engine + 1) % RASTER_ENGINE_COUNT);
+                printf("[INFO]: Using '%s' fill engine\n", raster_engine_names[raster->engine]);
+                        
+                raster_ctx_request(raster, lines);
+            } else if (e->key.keysym.sym == SDLK_m) {
+                raster->mode = (Raster_Mode) ((raster->mode + 1) % RASTER_MODE_COUNT);
+                printf("[INFO]: Using '%s' raster mode\n", raster_mode_names[raster->mode]);
+                        
+                raster_ctx_request(raster, lines);
+            } else if (e->key.keysym.sym == SDLK_p) {
+                raster->preview_factor = (raster->preview_factor >= PREVIEW_FACTOR_MAX) ? 1 : raster->preview_factor * 2;
+                printf("[INFO]: Drag preview factor %d\n", raster->preview_factor);
+            } else if (e->key.keysym.sym == SDLK_s) {
+                FILE *file = fopen("spans.txt", "w");
+                if (file == 0) {
+                    fprintf(stderr, "[ERROR]: Could not open 'spans.txt' for writing\n");
+                    break;
+                }
+
+                Span_Sink file_sink = span_sink_file(file);
+                rasterize(raster->engine, lines, 1, &file_sink, &frame_arena);
+                fclose(file);
+                        
+                printf("[INFO]: Saved spans to 'spans.txt'\n");
+            } else if (e->key.keysym.sym == SDLK_x) {
+                char path[EXPORT_PATH_MAX];
+                snprintf(path, sizeof(path), "raster_%03u.png", app->exporter.submitted);
+                if (export_writer_submit(&app->exporter, lines, raster->engine, path)) printf("[INFO]: Exporting to '%s'\n", path);
+            }
+        } break;
+
+        case SDL_MOUSEBUTTONDOWN: {
+            if (e->button.button == SDL_BUTTON_LEFT) {
+                app->mouse_held = true;
+                app->line_index = get_index_of_selected_origin(e->button.x, e->button.y, lines);
+            } else if (e->button.button == SDL_BUTTON_RIGHT) {
+                app->line_index = get_index_of_selected_origin(e->button.x, e->button.y, lines);
+
+                if (app->line_index == -1) add_new_point(e->button.x, e->button.y, lines);
+                else delete_point(app->line_index, lines);
+                        
+                raster_ctx_request(raster, lines);
+            }
+        } break;
+ 
+        case SDL_MOUSEBUTTONUP: {
+            if (e->button.button == SDL_BUTTON_LEFT) app->mouse_held = false;
+            app->line_index = -1;
+        } break;
+
+        case SDL_MOUSEMOTION: {
+            if (app->mouse_held && app->line_index != -1) {
+                s32 x = screen_to_fixed(e->motion.x);
+                s32 y = screen_to_fixed(e->motion.y);
+                        
+                if ((x > 0 && x < FIXED_FROM_CELLS(RECT_ROWS)) && (y > 0 && y < FIXED_FROM_CELLS(RECT_COLS))) {
+                    size_t connected_line = lines->data[app->line_index].prev;
+                    lines->data[app->line_index].x0 = lines->data[connected_line].x1 = x;
+                    lines->data[app->line_index].y0 = lines->data[connected_line].y1 = y;
+                        
+                    raster_ctx_request_preview(raster, lines);
+                }
+            }
+        } break;
+    }
+}
+
+internal void render_frame(Render_Ctx *context, Mask_Presenter *presenter, SDL_Rect *rects, App *app)
+{
+    SDL_SetRenderDrawColor(context->renderer, 18, 18, 18, 255);
+    SDL_RenderClear(context->renderer);
+        
+    // @Note: Banana-cakes
+    for (u32 i = 0; i < RECT_ROWS * RECT_COLS; ++i) {
+        SDL_SetRenderDrawColor(context->renderer, 80, 80, 80, 255);
+        SDL_RenderDrawRect(context->renderer, &rects[i]);
+    }
+
+    mask_presenter_update(presenter, raster_ctx_shown(&app->raster));
+    SDL_RenderCopy(context->renderer, presenter->texture, 0, 0);
+
+    for (u32 i = 0; i < app->lines.size; ++i) {
+        s32 x0 = fixed_to_screen(app->lines.data[i].x0);
+        s32 y0 = fixed_to_screen(app->lines.data[i].y0);
+        s32 x1 = fixed_to_screen(app->lines.data[i].x1);
+        s32 y1 = fixed_to_screen(app->lines.data[i].y1);
+
+        SDL_SetRenderDrawColor(context->renderer, 255, 0, 0, 255);
+            
+        SDL_RenderDrawLine(context->renderer, x0, y0, x1, y1);
+        
+        // @Note: Generated and loaded scenes can have so many vertices the handles would bury everything.
+        if (app->lines.size <= VERTEX_HANDLES_MAX) render_draw_circle(context->renderer, x0, y0, CIRCLE_RADIUS);
+    }
+
+    if (app->video) video_capture(app->video, context->renderer, app->raster.now);
+    
+    SDL_RenderPresent(context->renderer);
+}
+
+// @Note: Feeds a recording through the same handlers the live loop uses, either as fast as
+// possible or waiting for every frame's recorded time. Each frame waits for its raster job to
+// finish, so what gets presented only depends on the recording and not on thread timing.
+internal void alloc_counts_accumulate(Alloc_Counts *total, Alloc_Counts *frame)
+{
+    total->allocations += frame->allocations;
+    total->bytes += frame->bytes;
+    total->peak = MAX(total->peak, frame->peak);
+}
+
+// @Note: Returns false when the recording turned out to be malformed, whatever came before that
+// still got replayed.
+internal bool replay_recording(FILE *file, bool realtime, FILE *timings_file, Golden *golden, Alloc_Check *alloc_check, Render_Ctx *context, Mask_Presenter *presenter, SDL_Rect *rects, App *app)
+{
+    Frame_Timing timing = {};
+    Record record;
+    bool have_record = recording_read(file, &record);
+    bool malformed = !have_record && !feof(file);
+    if (malformed) fprintf(stderr, "[ERROR]: Malformed recording, unknown record type %u at the start\n", record.type);
+    
+    u32 replay_start = SDL_GetTicks();
+    if (timings_file) {
+        fprintf(timings_file, "frame,time_ms,raster_ms,present_ms,allocs,alloc_bytes,peak_bytes");
+        for (s32 phase = 0; phase < ALLOC_PHASE_COUNT; ++phase) fprintf(timings_file, ",%s_allocs", alloc_phase_names[phase]);
+        fprintf(timings_file, "\n");
+    }
+
+    // @Note: Whatever setting up took isn't the first frame's.
+    alloc_frame_end();
+    
+    while (have_record && !app->should_quit) {
+        if (record.type != RECORD_FRAME) {
+            fprintf(stderr, "[ERROR]: Malformed recording, expected a frame record\n");
+            malformed = true;
+            break;
+        }
+
+        app->raster.now = (u32) record.a;
+        arena_reset(&frame_arena);
+        if (realtime) {
+            while (SDL_GetTicks() - replay_start < app->raster.now) SDL_Delay(1);
+        }
+
+        // @Note: Let the user close the window, but nothing else from the live input gets through.
+        alloc_phase = ALLOC_PHASE_EVENTS;
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) app->should_quit = true;
+        }
+        
+        u64 raster_start = SDL_GetPerformanceCounter();
+        while ((have_record = recording_read(file, &record)) && record.type != RECORD_FRAME) {
+            SDL_Event replayed = event_from_record(&record);
+            app_handle_event(app, &replayed);
+        }
+
+        if (!have_record && !feof(file)) {
+            fprintf(stderr, "[ERROR]: Malformed recording, unknown record type %u after frame %u\n", record.type, timing.frames);
+            malformed = true;
+            break;
+        }
+        
+        bool dragging = app->mouse_held && app->line_index != -1;
+        alloc_phase = ALLOC_PHASE_RASTER;
+        raster_ctx_update(&app->raster, &app->lines, dragging);
+        raster_ctx_finish(&app->raster);
+        u64 raster_end = SDL_GetPerformanceCounter();
+
+        alloc_phase = ALLOC_PHASE_PRESENT;
+        render_frame(context, presenter, rects, app);
+        u64 present_end = SDL_GetPerformanceCounter();
+
+        alloc_phase = ALLOC_PHASE_OTHER;
+        if (golden) golden_frame(golden, timing.frames, raster_ctx_shown(&app->raster));
+
+        app->allocs = alloc_frame_end();
+        Alloc_Counts *allocs = &app->allocs.total;
+        alloc_counts_accumulate(&timing.allocs.total, allocs);
+        for (s32 phase = 0; phase < ALLOC_PHASE_COUNT; ++phase) alloc_counts_accumulate(&timing.allocs.phases[phase], &app->allocs.phases[phase]);
+        timing.allocations_max = MAX(timing.allocations_max, allocs->allocations);
+
+        if (alloc_check && dragging && timing.frames >= alloc_check->warmup_frames && allocs->allocations > 0) {
+            fprintf(stderr, "[ERROR]: Frame %u allocated %llu times (%llu bytes) while dragging:", timing.frames,
+                    (unsigned long long) allocs->allocations, (unsigned long long) allocs->bytes);
+            for (s32 phase = 0; phase < ALLOC_PHASE_COUNT; ++phase) {
+                if (app->allocs.phases[phase].allocations == 0) continue;
+                fprintf(stderr, " %s %llu", alloc_phase_names[phase], (unsigned long long) app->allocs.phases[phase].allocations);
+            }
+            fprintf(stderr, "\n");
+            
+            alloc_check->failed_frames += 1;
+        }
+
+        f64 raster_ms = elapsed_ms(raster_start, raster_end);
+        f64 present_ms = elapsed_ms(raster_end, present_end);
+        
+        timing.raster_ms_total += raster_ms;
+        timing.raster_ms_max = MAX(timing.raster_ms_max, raster_ms);
+        timing.present_ms_total += present_ms;
+        timing.present_ms_max = MAX(timing.present_ms_max, present_ms);
+
+        if (timings_file) {
+            fprintf(timings_file, "%u,%u,%.4f,%.4f,%llu,%llu,%llu", timing.frames, app->raster.now, raster_ms, present_ms,
+                    (unsigned long long) allocs->allocations, (unsigned long long) allocs->bytes, (unsigned long long) allocs->peak);
+            for (s32 phase = 0; phase < ALLOC_PHASE_COUNT; ++phase) fprintf(timings_file, ",%llu", (unsigned long long) app->allocs.phases[phase].allocations);
+            fprintf(timings_file, "\n");
+        }
+        timing.frames += 1;
+    }
+
+    if (malformed && timing.frames == 0) return(false);
+    if (timing.frames == 0) {
+        printf("[INFO]: Nothing to replay\n");
+        return(true);
+    }
+
+    printf("[INFO]: Replayed %u frames with '%s' engine in '%s' mode\n", timing.frames,
+           raster_engine_names[app->raster.engine], raster_mode_names[app->raster.mode]);
+    printf("[INFO]: Raster  avg %.4f ms, max %.4f ms\n", timing.raster_ms_total / timing.frames, timing.raster_ms_max);
+    printf("[INFO]: Present avg %.4f ms, max %.4f ms\n", timing.present_ms_total / timing.frames, timing.present_ms_max);
+    auto_engine_report();
+    printf("[INFO]: Arenas  high water %zu bytes '%s', %zu bytes '%s'\n", frame_arena.high_water, frame_arena.name,
+           app->raster.worker.arena.high_water, app->raster.worker.arena.name);
+    printf("[INFO]: Allocs  %llu (%llu bytes), max %llu in a frame, peak %llu bytes in use\n",
+           (unsigned long long) timing.allocs.total.allocations, (unsigned long long) timing.allocs.total.bytes,
+           (unsigned long long) timing.allocations_max, (unsigned long long) timing.allocs.total.peak);
+    
+    for (s32 phase = 0; phase < ALLOC_PHASE_COUNT; ++phase) {
+        Alloc_Counts *counts = &timing.allocs.phases[phase];
+        if (counts->allocations == 0) continue;
+        
+        printf("[INFO]:   %-8s %llu (%llu bytes)\n", alloc_phase_names[phase],
+               (unsigned long long) counts->allocations, (unsigned long long) counts->bytes);
+    }
+
+    return(!malformed);
+}
+
+// @Note: Rasterization service. Clients connect to a Unix domain socket and send framed
+// requests, every message (both ways) is little-endian:
+//
+//   u32 size (of everything after this field), u32 type, u32 id, payload
+//
+// SERVER_MESSAGE_RASTER payload:
+//   u32 width, u32 height    (grid cells, at most RECT_ROWS x RECT_COLS)
+//   u8 fill rule, u8 AA mode, u8 output, u8 engine
+//   u32 contours, then every contour as u32 points and points x (s32 x, s32 y) in 24.8 fixed point
+//
+// Responses carry the id of the request and start with a u32 status. A mask is u32 width,
+// u32 height and then 'height' rows of (width + 7) / 8 bytes, bit 'x % 8' of byte 'x / 8'
+// is cell x. Spans are u32 count and then count x (u16 y, u16 x0, u16 x1), x1 exclusive.
+// SERVER_MESSAGE_STATS has no payload and gets back the client's counters as u64s.
+//
+// Jobs go through one queue to a pool of workers, so responses can come back in a different
+// order than the requests went out. Each client can have SERVER_CLIENT_INFLIGHT jobs in
+// flight. Past that its connection doesn't get read anymore, and the client blocks once the
+// socket buffer fills up.
+#define SERVER_HEADER_SIZE 12
+#define SERVER_MESSAGE_MAX (16 * 1024 * 1024)
+#define SERVER_QUEUE_MAX 1024
+#define SERVER_CLIENT_INFLIGHT 256
+#define SERVER_CLIENTS_MAX 64
+#define SERVER_WORKERS_MAX 64
+#define SERVER_READ_BUFFER (64 * 1024)
+#define SERVER_SPAN_SIZE 6
+#define SERVER_RESPONSE_MAX (SERVER_HEADER_SIZE + 12 + SPANS_MAX * SERVER_SPAN_SIZE)
+#define CLIENT_WINDOW 128
+
+enum Server_Message {
+    SERVER_MESSAGE_RASTER = 1,
+    SERVER_MESSAGE_STATS,
+};
+
+enum Server_Status {
+    SERVER_STATUS_OK = 0,
+    SERVER_STATUS_MALFORMED,
+    SERVER_STATUS_UNSUPPORTED,
+};
+
+enum Server_Output {
+    SERVER_OUTPUT_MASK = 0,
+    SERVER_OUTPUT_SPANS,
+};
+
+// @Note: Only even-odd (see 'Fill_Rule') and no AA are implemented, the fields are there so
+// clients don't have to change once more show up. Anything else gets SERVER_STATUS_UNSUPPORTED.
+enum Aa_Mode {
+    AA_MODE_NONE = 0,
+};
+
+#ifdef RASTER_POSIX
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+struct Byte_Reader {
+    u8 *at;
+    u8 *end;
+    bool ok;
+};
+
+internal u32 byte_reader_u32(Byte_Reader *reader)
+{
+    if (reader->end - reader->at < 4) {
+        reader->ok = false;
+        return(0);
+    }
+
+    u32 value = read_u32_le(reader->at);
+    reader->at += 4;
+    return(value);
+}
+
+internal u8 byte_reader_u8(Byte_Reader *reader)
+{
+    if (reader->end - reader->at < 1) {
+        reader->ok = false;
+        return(0);
+    }
+
+    return(*reader->at++);
+}
+
+// @Note: A u32 contour count followed by every contour as a u32 point count and that many
+// (s32 x, s32 y) pairs. Appends them to 'lines', on a malformed one 'lines' is left with what was
+// there before.
+internal bool byte_reader_contours(Byte_Reader *reader, Line_Array *lines, Arena *scratch)
+{
+    size_t base = lines->size;
+    u32 contours = byte_reader_u32(reader);
+
+    for (u32 contour = 0; contour < contours && reader->ok; ++contour) {
+        u32 count = byte_reader_u32(reader);
+        if (!reader->ok || count < 3 || count > (size_t) (reader->end - reader->at) / 8) {
+            reader->ok = false;
+            break;
+        }
+
+        Arena_Temp temp = arena_begin_temp(scratch);
+        s32 *xs = ARENA_PUSH_ARRAY(scratch, s32, count);
+        s32 *ys = ARENA_PUSH_ARRAY(scratch, s32, count);
+        for (u32 i = 0; i < count; ++i) {
+            xs[i] = (s32) byte_reader_u32(reader);
+            ys[i] = (s32) byte_reader_u32(reader);
+        }
+
+        line_array_add_contour(lines, xs, ys, count);
+        arena_end_temp(temp);
+    }
+
+    if (!reader->ok) lines->size = base;
+    return(reader->ok);
+}
+
+internal void write_u16_le(u8 *out, u32 value)
+{
+    out[0] = (u8) (value);
+    out[1] = (u8) (value >> 8);
+}
+
+internal u32 read_u16_le(u8 *in)
+{
+    return((u32) in[0] | ((u32) in[1] << 8));
+}
+
+internal void write_u64_le(u8 *out, u64 value)
+{
+    write_u32_le(out, (u32) value);
+    write_u32_le(out + 4, (u32) (value >> 32));
+}
+
+internal u64 read_u64_le(u8 *in)
+{
+    return((u64) read_u32_le(in) | ((u64) read_u32_le(in + 4) << 32));
+}
+
+// @Note: Reads a request's contours into 'lines' and checks the rest of it. Returns the status
+// the response should carry.
+internal Server_Status server_parse_raster(Byte_Reader *reader, Line_Array *lines, Arena *scratch, u32 *width, u32 *height, u8 *output, Raster_Engine *engine)
+{
+    *width = byte_reader_u32(reader);
+    *height = byte_reader_u32(reader);
+    u8 fill_rule = byte_reader_u8(reader);
+    u8 aa = byte_reader_u8(reader);
+    *output = byte_reader_u8(reader);
+    u8 engine_index = byte_reader_u8(reader);
+    if (!reader->ok || *output > SERVER_OUTPUT_SPANS || engine_index >= RASTER_ENGINE_COUNT) return(SERVER_STATUS_MALFORMED);
+
+    *engine = (Raster_Engine) engine_index;
+    lines->size = 0;
+    if (!byte_reader_contours(reader, lines, scratch) || reader->at != reader->end || lines->size == 0) return(SERVER_STATUS_MALFORMED);
+    if (fill_rule != FILL_RULE_EVEN_ODD || aa != AA_MODE_NONE) return(SERVER_STATUS_UNSUPPORTED);
+    if (*width == 0 || *width > RECT_ROWS || *height == 0 || *height > RECT_COLS) return(SERVER_STATUS_UNSUPPORTED);
+
+    return(SERVER_STATUS_OK);
+}
+
+// @Note: Bytes of payload written after the status.
+internal size_t server_encode_mask(Coverage_Mask *mask, u32 width, u32 height, u8 *out)
+{
+    u32 row_bytes = (width + 7) / 8;
+    write_u32_le(out, width);
+    write_u32_le(out + 4, height);
+    out += 8;
+
+    for (u32 y = 0; y < height; ++y) {
+        u64 *row = &mask->words[MASK_WORDS * y];
+        for (u32 b = 0; b < row_bytes; ++b) {
+            u8 byte = (u8) (row[b / 8] >> (8 * (b % 8)));
+            if (b == row_bytes - 1 && width % 8 != 0) byte &= (u8) ((1u << (width % 8)) - 1);
+            *out++ = byte;
+        }
+    }
+
+    return(8 + (size_t) row_bytes * height);
+}
+
+// @Note: The engines' spans as they come, cut to the requested grid.
+internal size_t server_encode_spans(Span_Array *spans, u32 width, u32 height, u8 *out)
+{
+    u32 count = 0;
+    u8 *at = out + 4;
+
+    for (size_t i = 0; i < spans->size; ++i) {
+        Span *span = &spans->data[i];
+        u32 x1 = MIN((u32) span->x1, width);
+        if ((u32) span->y >= height || (u32) span->x0 >= x1) continue;
+
+        write_u16_le(at, (u32) span->y);
+        write_u16_le(at + 2, (u32) span->x0);
+        write_u16_le(at + 4, x1);
+        at += SERVER_SPAN_SIZE;
+        count += 1;
+    }
+
+    write_u32_le(out, count);
+    return(4 + (size_t) count * SERVER_SPAN_SIZE);
+}
+
+struct Socket_Reader {
+    s32 fd;
+    size_t start;
+    size_t end;
+    u8 buffer[SERVER_READ_BUFFER];
+};
+
+// @Note: Returns false once the other side is gone.
+internal bool socket_read(Socket_Reader *reader, u8 *out, size_t size)
+{
+    while (size > 0) {
+        if (reader->start == reader->end) {
+            ssize_t got = recv(reader->fd, reader->buffer, sizeof(reader->buffer), 0);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return(false);
+
+            reader->start = 0;
+            reader->end = (size_t) got;
+        }
+
+        size_t take = MIN(size, reader->end - reader->start);
+        memcpy(out, reader->buffer + reader->start, take);
+        reader->start += take;
+        out += take;
+        size -= take;
+    }
+
+    return(true);
+}
+
+internal bool socket_write(s32 fd, u8 *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t sent = send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return(false);
+
+        data += sent;
+        size -= (size_t) sent;
+    }
+
+    return(true);
+}
+
+struct Server;
+
+// @Note: The reader thread owns the connection and 'reader'. Workers only write responses and
+// update the counters, both under 'write_lock'.
+struct Server_Client {
+    Server *server;
+    s32 fd;
+    u32 id;
+    SDL_mutex *write_lock;
+    SDL_sem *slots;
+    Socket_Reader reader;
+    u64 connected;
+
+    u64 jobs;
+    u64 failed;
+    u64 bytes_in;
+    u64 bytes_out;
+    u64 raster_ns;
+    u64 wait_ns;
+    u64 wait_ns_max;
+};
+
+struct Server_Job {
+    Server_Client *client;
+    u32 id;
+    u32 size;
+    u64 queued;
+    // @Note: The payload follows right after.
+};
+
+struct Server_Worker {
+    Server *server;
+    SDL_Thread *thread;
+    Arena arena;
+    Line_Array lines;
+    Coverage_Mask mask;
+    Span_Array spans;
+    u8 response[SERVER_RESPONSE_MAX];
+};
+
+struct Server {
+    s32 listen_fd;
+
+    SDL_mutex *lock;
+    SDL_cond *not_empty;
+    SDL_cond *not_full;
+    Server_Job *queue[SERVER_QUEUE_MAX];
+    u32 queue_head;
+    u32 queue_count;
+    bool quit;
+
+    Server_Client *clients[SERVER_CLIENTS_MAX];
+    u32 next_client_id;
+    u64 jobs;
+
+    Server_Worker workers[SERVER_WORKERS_MAX];
+    s32 worker_count;
+};
+
+global volatile sig_atomic_t server_stop_requested;
+
+internal void server_handle_signal(int signal_number)
+{
+    UNUSED(signal_number);
+    server_stop_requested = 1;
+}
+
+// @Note: Blocks while the queue is full, that's where backpressure from all clients together
+// comes from.
+internal void server_push(Server *server, Server_Job *job)
+{
+    SDL_LockMutex(server->lock);
+    while (server->queue_count == SERVER_QUEUE_MAX) SDL_CondWait(server->not_full, server->lock);
+
+    server->queue[(server->queue_head + server->queue_count) % SERVER_QUEUE_MAX] = job;
+    server->queue_count += 1;
+    SDL_CondSignal(server->not_empty);
+    SDL_UnlockMutex(server->lock);
+}
+
+// @Note: Returns 0 once the server shuts down and the queue is empty.
+internal Server_Job *server_pop(Server *server)
+{
+    SDL_LockMutex(server->lock);
+    while (server->queue_count == 0 && !server->quit) SDL_CondWait(server->not_empty, server->lock);
+
+    Server_Job *job = 0;
+    if (server->queue_count > 0) {
+        job = server->queue[server->queue_head];
+        server->queue_head = (server->queue_head + 1) % SERVER_QUEUE_MAX;
+        server->queue_count -= 1;
+        server->jobs += 1;
+        SDL_CondSignal(server->not_full);
+    }
+    SDL_UnlockMutex(server->lock);
+
+    return(job);
+}
+
+internal void server_write_header(u8 *out, size_t payload, u32 type, u32 id, Server_Status status)
+{
+    write_u32_le(out, (u32) (8 + 4 + payload));
+    write_u32_le(out + 4, type);
+    write_u32_le(out + 8, id);
+    write_u32_le(out + 12, status);
+}
+
+internal int server_worker_thread(void *data)
+{
+    Server_Worker *worker = (Server_Worker *) data;
+    alloc_phase = ALLOC_PHASE_WORKER;
+
+    while (Server_Job *job = server_pop(worker->server)) {
+        Server_Client *client = job->client;
+        u64 start = SDL_GetPerformanceCounter();
+        arena_reset(&worker->arena);
+
+        Byte_Reader reader = {(u8 *) (job + 1), (u8 *) (job + 1) + job->size, true};
+        u32 width, height;
+        u8 output;
+        Raster_Engine engine;
+        Server_Status status = server_parse_raster(&reader, &worker->lines, &worker->arena, &width, &height, &output, &engine);
+
+        size_t payload = 0;
+        if (status == SERVER_STATUS_OK) {
+            u8 *out = worker->response + SERVER_HEADER_SIZE + 4;
+            if (output == SERVER_OUTPUT_MASK) {
+                Span_Sink sink = span_sink_mask(&worker->mask);
+                rasterize(engine, &worker->lines, 1, &sink, &worker->arena);
+                payload = server_encode_mask(&worker->mask, width, height, out);
+            } else {
+                Span_Sink sink = span_sink_spans(&worker->spans);
+                rasterize(engine, &worker->lines, 1, &sink, &worker->arena);
+                payload = server_encode_spans(&worker->spans, width, height, out);
+            }
+        }
+
+        server_write_header(worker->response, payload, SERVER_MESSAGE_RASTER, job->id, status);
+        u64 end = SDL_GetPerformanceCounter();
+
+        SDL_LockMutex(client->write_lock);
+        socket_write(client->fd, worker->response, SERVER_HEADER_SIZE + 4 + payload);
+
+        u64 wait_ns = (u64) (elapsed_ms(job->queued, start) * 1e6);
+        client->jobs += 1;
+        client->failed += status != SERVER_STATUS_OK;
+        client->bytes_out += SERVER_HEADER_SIZE + 4 + payload;
+        client->raster_ns += (u64) (elapsed_ms(start, end) * 1e6);
+        client->wait_ns += wait_ns;
+        client->wait_ns_max = MAX(client->wait_ns_max, wait_ns);
+        SDL_UnlockMutex(client->write_lock);
+
+        SDL_free(job);
+        SDL_SemPost(client->slots);
+    }
+
+    return(0);
+}
+
+internal void server_respond(Server_Client *client, u32 type, u32 id, Server_Status status, u8 *payload, size_t size)
+{
+    u8 header[SERVER_HEADER_SIZE + 4];
+    server_write_header(header, size, type, id, status);
+
+    SDL_LockMutex(client->write_lock);
+    socket_write(client->fd, header, sizeof(header));
+    if (size > 0) socket_write(client->fd, payload, size);
+    client->bytes_out += sizeof(header) + size;
+    SDL_UnlockMutex(client->write_lock);
+}
+
+internal void server_client_report(Server_Client *client)
+{
+    f64 seconds = elapsed_ms(client->connected, SDL_GetPerformanceCounter()) / 1000.0;
+    f64 jobs = (f64) MAX(client->jobs, 1);
+
+    printf("[INFO]: Client %u: %llu jobs (%llu failed) in %.2f s, %.0f jobs/s, %llu bytes in, %llu bytes out\n", client->id,
+           (unsigned long long) client->jobs, (unsigned long long) client->failed, seconds, client->jobs / MAX(seconds, 1e-9),
+           (unsigned long long) client->bytes_in, (unsigned long long) client->bytes_out);
+    printf("[INFO]: Client %u: raster avg %.2f us, queue wait avg %.2f us, max %.2f us\n", client->id,
+           client->raster_ns / jobs / 1000.0, client->wait_ns / jobs / 1000.0, client->wait_ns_max / 1000.0);
+}
+
+// @Note: One per connection, reads requests and queues them. Once the client hangs up it waits
+// for the jobs still in flight, every one of them gives its slot back when it's done.
+internal int server_client_thread(void *data)
+{
+    Server_Client *client = (Server_Client *) data;
+    Server *server = client->server;
+    alloc_phase = ALLOC_PHASE_EVENTS;
+
+    for (;;) {
+        u8 header[SERVER_HEADER_SIZE];
+        if (!socket_read(&client->reader, header, sizeof(header))) break;
+
+        u32 size = read_u32_le(header);
+        u32 type = read_u32_le(header + 4);
+        u32 id = read_u32_le(header + 8);
+        if (size < 8 || size - 8 > SERVER_MESSAGE_MAX) {
+            server_respond(client, type, id, SERVER_STATUS_MALFORMED, 0, 0);
+            break;
+        }
+
+        u32 payload = size - 8;
+        client->bytes_in += SERVER_HEADER_SIZE + payload;
+
+        if (type == SERVER_MESSAGE_RASTER) {
+            SDL_SemWait(client->slots);
+
+            Server_Job *job = (Server_Job *) SDL_malloc(sizeof(Server_Job) + payload);
+            ERROR_EXIT(job == 0, "[ERROR]: Out of memory for a %u byte request\n", payload);
+            job->client = client;
+            job->id = id;
+            job->size = payload;
+
+            if (!socket_read(&client->reader, (u8 *) (job + 1), payload)) {
+                SDL_free(job);
+                SDL_SemPost(client->slots);
+                break;
+            }
+
+            job->queued = SDL_GetPerformanceCounter();
+            server_push(server, job);
+            continue;
+        }
+
+        // @Note: Nothing else has a payload, whatever is there gets skipped.
+        bool connected = true;
+        for (u32 skipped = 0; skipped < payload && connected; ++skipped) {
+            u8 byte;
+            connected = socket_read(&client->reader, &byte, 1);
+        }
+        if (!connected) break;
+
+        if (type == SERVER_MESSAGE_STATS) {
+            u8 stats[7 * 8];
+            SDL_LockMutex(client->write_lock);
+            write_u64_le(stats + 0, client->jobs);
+            write_u64_le(stats + 8, client->failed);
+            write_u64_le(stats + 16, client->bytes_in);
+            write_u64_le(stats + 24, client->bytes_out);
+            write_u64_le(stats + 32, client->raster_ns);
+            write_u64_le(stats + 40, client->wait_ns);
+            write_u64_le(stats + 48, client->wait_ns_max);
+            SDL_UnlockMutex(client->write_lock);
+
+            server_respond(client, type, id, SERVER_STATUS_OK, stats, sizeof(stats));
+        } else {
+            server_respond(client, type, id, SERVER_STATUS_UNSUPPORTED, 0, 0);
+        }
+    }
+
+    for (s32 i = 0; i < SERVER_CLIENT_INFLIGHT; ++i) SDL_SemWait(client->slots);
+    server_client_report(client);
+
+    SDL_LockMutex(server->lock);
+    for (s32 i = 0; i < SERVER_CLIENTS_MAX; ++i) {
+        if (server->clients[i] == client) server->clients[i] = 0;
+    }
+    SDL_UnlockMutex(server->lock);
+
+    close(client->fd);
+    SDL_DestroySemaphore(client->slots);
+    SDL_DestroyMutex(client->write_lock);
+    SDL_free(client);
+
+    return(0);
+}
+
+internal void server_accept(Server *server)
+{
+    s32 fd = accept(server->listen_fd, 0, 0);
+    if (fd < 0) return;
+
+    SDL_LockMutex(server->lock);
+    s32 slot = -1;
+    for (s32 i = 0; i < SERVER_CLIENTS_MAX && slot == -1; ++i) {
+        if (!server->clients[i]) slot = i;
+    }
+    SDL_UnlockMutex(server->lock);
+
+    if (slot == -1) {
+        fprintf(stderr, "[WARNING]: Already serving %d clients, turning one away\n", SERVER_CLIENTS_MAX);
+        close(fd);
+        return;
+    }
+
+    Server_Client *client = (Server_Client *) SDL_calloc(1, sizeof(Server_Client));
+    ERROR_EXIT(client == 0, "[ERROR]: Out of memory for a client\n");
+    client->server = server;
+    client->fd = fd;
+    client->id = ++server->next_client_id;
+    client->write_lock = SDL_CreateMutex();
+    client->slots = SDL_CreateSemaphore(SERVER_CLIENT_INFLIGHT);
+    client->reader.fd = fd;
+    client->connected = SDL_GetPerformanceCounter();
+    ERROR_EXIT(client->write_lock == 0 || client->slots == 0, "[ERROR]: Could not set up client -> %s\n", SDL_GetError());
+
+    SDL_LockMutex(server->lock);
+    server->clients[slot] = client;
+    SDL_UnlockMutex(server->lock);
+
+    SDL_Thread *thread = SDL_CreateThread(server_client_thread, "raster_client", client);
+    ERROR_EXIT(thread == 0, "[ERROR]: Could not create client thread -> %s\n", SDL_GetError());
+    SDL_DetachThread(thread);
+
+    printf("[INFO]: Client %u connected\n", client->id);
+}
+
+// @Note: Serves until SIGINT/SIGTERM, then stops taking connections, lets every client's jobs
+// finish and reports.
+internal s32 run_server(const char *path, s32 worker_count)
+{
+    // @Note: Big, keep it off the stack.
+    static Server server;
+
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "[ERROR]: Socket path '%s' is too long\n", path);
+        return(1);
+    }
+    strcpy(address.sun_path, path);
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, server_handle_signal);
+    signal(SIGTERM, server_handle_signal);
+
+    server.listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ERROR_EXIT(server.listen_fd < 0, "[ERROR]: Could not create socket -> %s\n", strerror(errno));
+    unlink(path);
+    ERROR_EXIT(bind(server.listen_fd, (struct sockaddr *) &address, sizeof(address)) != 0, "[ERROR]: Could not bind '%s' -> %s\n", path, strerror(errno));
+    ERROR_EXIT(listen(server.listen_fd, SERVER_CLIENTS_MAX) != 0, "[ERROR]: Could not listen on '%s' -> %s\n", path, strerror(errno));
+
+    server.lock = SDL_CreateMutex();
+    server.not_empty = SDL_CreateCond();
+    server.not_full = SDL_CreateCond();
+    ERROR_EXIT(!server.lock || !server.not_empty || !server.not_full, "[ERROR]: Could not set up the queue -> %s\n", SDL_GetError());
+
+    server.worker_count = MIN(MAX(worker_count, 1), SERVER_WORKERS_MAX);
+    for (s32 i = 0; i < server.worker_count; ++i) {
+        Server_Worker *worker = &server.workers[i];
+        worker->server = &server;
+        worker->arena.name = "server";
+        worker->thread = SDL_CreateThread(server_worker_thread, "raster_server", worker);
+        ERROR_EXIT(worker->thread == 0, "[ERROR]: Could not create server worker -> %s\n", SDL_GetError());
+    }
+
+    printf("[INFO]: Serving on '%s' with %d workers\n", path, server.worker_count);
+    fflush(stdout);
+
+    while (!server_stop_requested) {
+        struct pollfd listener = {server.listen_fd, POLLIN, 0};
+        if (poll(&listener, 1, 250) > 0) server_accept(&server);
+    }
+
+    printf("[INFO]: Shutting down\n");
+    close(server.listen_fd);
+    unlink(path);
+
+    // @Note: Readers see the hang up, wait for their jobs and go away on their own.
+    for (;;) {
+        s32 connected = 0;
+        SDL_LockMutex(server.lock);
+        for (s32 i = 0; i < SERVER_CLIENTS_MAX; ++i) {
+            if (!server.clients[i]) continue;
+            shutdown(server.clients[i]->fd, SHUT_RD);
+            connected += 1;
+        }
+        SDL_UnlockMutex(server.lock);
+
+        if (connected == 0) break;
+        SDL_Delay(10);
+    }
+
+    SDL_LockMutex(server.lock);
+    server.quit = true;
+    SDL_CondBroadcast(server.not_empty);
+    SDL_UnlockMutex(server.lock);
+
+    for (s32 i = 0; i < server.worker_count; ++i) {
+        SDL_WaitThread(server.workers[i].thread, 0);
+        line_array_free(&server.workers[i].lines);
+        arena_free(&server.workers[i].arena);
+    }
+
+    printf("[INFO]: Served %llu jobs to %u clients\n", (unsigned long long) server.jobs, server.next_client_id);
+    SDL_DestroyCond(server.not_full);
+    SDL_DestroyCond(server.not_empty);
+    SDL_DestroyMutex(server.lock);
+
+    return(0);
+}
+
+// @Note: Appends a raster request for every closed path of 'lines' to 'out', returns its size.
+internal size_t client_encode_request(Line_Array *lines, u32 id, Raster_Engine engine, Server_Output output, u8 *visited, u8 *out)
+{
+    u8 *at = out + SERVER_HEADER_SIZE;
+    write_u32_le(at, RECT_ROWS);
+    write_u32_le(at + 4, RECT_COLS);
+    at[8] = FILL_RULE_EVEN_ODD;
+    at[9] = AA_MODE_NONE;
+    at[10] = (u8) output;
+    at[11] = (u8) engine;
+    u8 *contours = at + 12;
+    at += 16;
+
+    u32 contour_count = 0;
+    memset(visited, 0, lines->size);
+
+    for (size_t start = 0; start < lines->size; ++start) {
+        if (visited[start]) continue;
+
+        u8 *count = at;
+        at += 4;
+
+        u32 points = 0;
+        size_t i = start;
+        do {
+            visited[i] = 1;
+            write_u32_le(at, (u32) lines->data[i].x0);
+            write_u32_le(at + 4, (u32) lines->data[i].y0);
+            at += 8;
+            points += 1;
+            i = lines->data[i].next;
+        } while (i != start);
+
+        write_u32_le(count, points);
+        contour_count += 1;
+    }
+
+    write_u32_le(contours, contour_count);
+
+    size_t size = (size_t) (at - out);
+    write_u32_le(out, (u32) (size - 4));
+    write_u32_le(out + 4, SERVER_MESSAGE_RASTER);
+    write_u32_le(out + 8, id);
+    return(size);
+}
+
+internal bool client_check_mask(u8 *payload, size_t size, Coverage_Mask *expected)
+{
+    if (size < 8 || read_u32_le(payload) != RECT_ROWS || read_u32_le(payload + 4) != RECT_COLS) return(false);
+
+    u32 row_bytes = (RECT_ROWS + 7) / 8;
+    if (size != 8 + (size_t) row_bytes * RECT_COLS) return(false);
+
+    for (s32 y = 0; y < RECT_COLS; ++y) {
+        for (s32 x = 0; x < RECT_ROWS; ++x) {
+            bool filled = (payload[8 + row_bytes * y + x / 8] >> (x % 8)) & 1;
+            if (filled != coverage_mask_is_filled(expected, x, y)) return(false);
+        }
+    }
+
+    return(true);
+}
+
+// @Note: Only the cells the spans cover count, not how they're split up.
+internal bool client_check_spans(u8 *payload, size_t size, Coverage_Mask *expected)
+{
+    static Coverage_Mask got;
+    if (size < 4) return(false);
+
+    u32 count = read_u32_le(payload);
+    if (size != 4 + (size_t) count * SERVER_SPAN_SIZE) return(false);
+
+    memset(got.words, 0, sizeof(got.words));
+    for (u32 i = 0; i < count; ++i) {
+        u8 *span = payload + 4 + (size_t) i * SERVER_SPAN_SIZE;
+        u32 y = read_u16_le(span);
+        u32 x0 = read_u16_le(span + 2);
+        u32 x1 = read_u16_le(span + 4);
+        if (y >= RECT_COLS || x0 >= x1 || x1 > RECT_ROWS) return(false);
+
+        coverage_mask_fill(&got, (s32) y, (s32) x0, (s32) x1);
+    }
+
+    s32 x;
+    s32 y;
+    return(!coverage_mask_first_difference(expected, &got, &x, &y));
+}
+
+// @Note: Sends 'jobs' requests with up to CLIENT_WINDOW of them in flight and checks every mask
+// that comes back against rasterizing it here, every other request asks for spans instead.
+// Responses come back in any order, a request only goes out once the one before it in the same
+// slot is back. The shapes are 'scene' every time, or the same kinds of shapes as '-diff' when
+// there's none.
+internal s32 run_client(const char *path, u32 jobs, Line_Array *scene, Raster_Engine engine, u64 seed)
+{
+    // @Note: Big, keep it off the stack.
+    static Coverage_Mask expected[CLIENT_WINDOW];
+    static bool in_flight[CLIENT_WINDOW];
+    static Socket_Reader reader;
+
+    struct sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "[ERROR]: Socket path '%s' is too long\n", path);
+        return(1);
+    }
+    strcpy(address.sun_path, path);
+
+    s32 fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    ERROR_EXIT(fd < 0, "[ERROR]: Could not create socket -> %s\n", strerror(errno));
+    ERROR_EXIT(connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0, "[ERROR]: Could not connect to '%s' -> %s\n", path, strerror(errno));
+    reader.fd = fd;
+
+    Random_Series series = random_seed(seed);
+    Line_Array shape = {};
+    u8 *request = 0;
+    size_t request_capacity = 0;
+    u8 *response = 0;
+    size_t response_capacity = 0;
+    u32 sent = 0;
+    u32 received = 0;
+    u32 mismatches = 0;
+    bool connected = true;
+
+    u64 start = SDL_GetPerformanceCounter();
+
+    while (received < jobs && connected) {
+        while (sent < jobs && !in_flight[sent % CLIENT_WINDOW] && connected) {
+            Line_Array *lines = scene;
+            if (!lines) {
+                diff_make_shape((Diff_Shape) (sent % DIFF_SHAPE_COUNT), &series, &shape);
+                lines = &shape;
+            }
+
+            // @Note: Header, grid and options, contour counts and the points.
+            size_t needed = SERVER_HEADER_SIZE + 16 + lines->size * 12 + lines->size;
+            if (needed > request_capacity) {
+                request_capacity = MAX(needed, 2 * request_capacity);
+                request = (u8 *) SDL_realloc(request, request_capacity);
+                ERROR_EXIT(request == 0, "[ERROR]: Out of memory for a %zu byte request\n", request_capacity);
+            }
+
+            u8 *visited = request + needed - lines->size;
+            Server_Output output = (sent % 2 == 0) ? SERVER_OUTPUT_MASK : SERVER_OUTPUT_SPANS;
+            size_t size = client_encode_request(lines, sent, engine, output, visited, request);
+            connected = socket_write(fd, request, size);
+
+            arena_reset(&frame_arena);
+            Span_Sink sink = span_sink_mask(&expected[sent % CLIENT_WINDOW]);
+            rasterize(RASTER_ENGINE_TILED, lines, 1, &sink, &frame_arena);
+            in_flight[sent % CLIENT_WINDOW] = true;
+            sent += 1;
+        }
+
+        u8 header[SERVER_HEADER_SIZE];
+        if (!connected || !socket_read(&reader, header, sizeof(header))) break;
+
+        u32 size = read_u32_le(header);
+        u32 id = read_u32_le(header + 8);
+        if (size < 12 || size - 8 > SERVER_MESSAGE_MAX) break;
+
+        if (size - 8 > response_capacity) {
+            response_capacity = size - 8;
+            response = (u8 *) SDL_realloc(response, response_capacity);
+            ERROR_EXIT(response == 0, "[ERROR]: Out of memory for a %zu byte response\n", response_capacity);
+        }
+        if (!socket_read(&reader, response, size - 8)) break;
+
+        u32 status = read_u32_le(response);
+        if (id >= sent || sent - id > CLIENT_WINDOW || !in_flight[id % CLIENT_WINDOW]) {
+            fprintf(stderr, "[ERROR]: Got a response to job %u which isn't in flight\n", id);
+            break;
+        }
+
+        bool correct = (id % 2 == 0) ? client_check_mask(response + 4, size - 12, &expected[id % CLIENT_WINDOW]) :
+            client_check_spans(response + 4, size - 12, &expected[id % CLIENT_WINDOW]);
+        if (status != SERVER_STATUS_OK || !correct) {
+            if (mismatches == 0) fprintf(stderr, "[ERROR]: Job %u came back wrong, status %u\n", id, status);
+            mismatches += 1;
+        }
+        in_flight[id % CLIENT_WINDOW] = false;
+        received += 1;
+    }
+
+    u64 end = SDL_GetPerformanceCounter();
+    f64 seconds = elapsed_ms(start, end) / 1000.0;
+    printf("[INFO]: %u of %u jobs back in %.2f s, %.0f jobs/s, %u wrong\n", received, jobs, seconds, received / MAX(seconds, 1e-9), mismatches);
+
+    // @Note: Everything is back, the server's counters for us are final.
+    u8 stats_request[SERVER_HEADER_SIZE];
+    write_u32_le(stats_request, 8);
+    write_u32_le(stats_request + 4, SERVER_MESSAGE_STATS);
+    write_u32_le(stats_request + 8, 0);
+
+    u8 stats[SERVER_HEADER_SIZE + 4 + 7 * 8];
+    if (received == jobs && socket_write(fd, stats_request, sizeof(stats_request)) && socket_read(&reader, stats, sizeof(stats))) {
+        u8 *counters = stats + SERVER_HEADER_SIZE + 4;
+        f64 served = (f64) MAX(read_u64_le(counters), 1);
+        printf("[INFO]: Server says %llu jobs, %llu failed, raster avg %.2f us, queue wait avg %.2f us, max %.2f us\n",
+               (unsigned long long) read_u64_le(counters), (unsigned long long) read_u64_le(counters + 8),
+               read_u64_le(counters + 32) / served / 1000.0, read_u64_le(counters + 40) / served / 1000.0, read_u64_le(counters + 48) / 1000.0);
+    }
+
+    close(fd);
+    line_array_free(&shape);
+    SDL_free(request);
+    SDL_free(response);
+
+    return(received == jobs && mismatches == 0 ? 0 : 1);
+}
+
+// @Note: Shared memory exchange for a producer on the same machine. One POSIX shared memory
+// object holds a header, a ring of request slots the producer builds its lines in and a ring
+// of result slots the rasterizer writes masks into. Neither side copies anything, the engines
+// read the lines straight out of the request slot and write the mask straight into the result
+// slot. Both rings have one writer and one reader, 'head' counts what the writer published and
+// 'tail' what the reader is done with. Whoever has to wait for the other side sleeps on the
+// counter it's waiting for, a futex on Linux.
+//
+// Lines are the same struct the engines use, so producer and rasterizer have to be built for
+// the same grid and ABI, which the header checks.
+#define SHM_MAGIC 0x4D485344 // 'DSHM'
+#define SHM_VERSION 2
+#define SHM_SLOTS 64
+// @Note: Fits every '-diff' shape, generated ones included.
+#define SHM_SLOT_LINES 4096
+#define SHM_WAIT_MS 250
+#define SHM_CHECK_INTERVAL 16
+
+struct Shm_Counter {
+    SDL_atomic_t value;
+    SDL_atomic_t waiters;
+};
+
+struct Shm_Request {
+    u32 id;
+    u32 engine;
+    u64 size;
+    Line lines[SHM_SLOT_LINES];
+};
+
+struct Shm_Result {
+    u32 id;
+    u32 lines;
+    u64 raster_ns;
+    Coverage_Mask mask;
+};
+
+struct Shm_Header {
+    u32 magic;
+    u32 version;
+    u32 rows;
+    u32 cols;
+    u32 line_size;
+    u32 slots;
+    u32 slot_lines;
+
+    // @Note: The producer's pid while one is attached, 'closed' gets set once it's done. The
+    // rasterizer starts over after that, or when the pid is gone without having closed.
+    SDL_atomic_t producer;
+    SDL_atomic_t closed;
+
+    Shm_Counter request_head;
+    Shm_Counter request_tail;
+    Shm_Counter result_head;
+    Shm_Counter result_tail;
+};
+
+struct Shm_Layout {
+    Shm_Header header;
+    Shm_Request requests[SHM_SLOTS];
+    Shm_Result results[SHM_SLOTS];
+};
+
+#ifdef __linux__
+internal void shm_futex_wait(SDL_atomic_t *address, s32 expected, u32 timeout_ms)
+{
+    struct timespec timeout = {(time_t) (timeout_ms / 1000), (long) (timeout_ms % 1000) * 1000000};
+    syscall(SYS_futex, &address->value, FUTEX_WAIT, expected, &timeout, 0, 0);
+}
+
+internal void shm_futex_wake(SDL_atomic_t *address)
+{
+    syscall(SYS_futex, &address->value, FUTEX_WAKE, INT32_MAX, 0, 0, 0);
+}
+#else
+// @Note: No futex, sleep a little and look again.
+internal void shm_futex_wait(SDL_atomic_t *address, s32 expected, u32 timeout_ms)
+{
+    UNUSED(address);
+    UNUSED(expected);
+    UNUSED(timeout_ms);
+    usleep(50);
+}
+
+internal void shm_futex_wake(SDL_atomic_t *address) { UNUSED(address); }
+#endif
+
+// @Note: Waits while the counter is still 'value', gives up after SHM_WAIT_MS so the caller
+// can check whether it should stop. Returns the counter.
+internal u32 shm_counter_wait(Shm_Counter *counter, u32 value)
+{
+    u32 current = (u32) SDL_AtomicGet(&counter->value);
+
+    // @Note: The other side is usually just about done, spin a bit before going to sleep.
+    for (s32 spin = 0; spin < 256 && current == value; ++spin) {
+        SDL_CPUPauseInstruction();
+        current = (u32) SDL_AtomicGet(&counter->value);
+    }
+
+    if (current == value) {
+        SDL_AtomicAdd(&counter->waiters, 1);
+        shm_futex_wait(&counter->value, (s32) value, SHM_WAIT_MS);
+        SDL_AtomicAdd(&counter->waiters, -1);
+        current = (u32) SDL_AtomicGet(&counter->value);
+    }
 
-    // @Note: Find closest line between next and prev.
-    size_t next = lines->data[index].next;
-    size_t prev = lines->data[index].prev;
-    u32 dist_next = sqr_distance(x0, y0, lines->data[next].x0, lines->data[next].y0);
-    u32 dist_prev = sqr_distance(x0, y0, lines->data[prev].x0, lines->data[prev].y0);
-    
-    if (dist_next <= dist_prev) {
-        line_array_add(lines, x0, y0, lines->data[next].x0, lines->data[next].y0);
-        line_array_connect(lines, lines->size - 1, next, index);
-        line_array_reconnect(lines, index, lines->size - 1, next, x0, y0);
-    } else {
-        line_array_add(lines, x0, y0, lines->data[index].x0, lines->data[index].y0);
-        line_array_connect(lines, lines->size - 1, index, prev);
-        line_array_reconnect(lines, prev, lines->size - 1, index, x0, y0);
+    return(current);
+}
+
+// @Note: Only goes to the kernel when somebody is asleep, SDL's atomics are full barriers so a
+// waiter either sees the new value or gets counted here.
+internal void shm_counter_publish(Shm_Counter *counter, u32 value)
+{
+    SDL_AtomicSet(&counter->value, (s32) value);
+    if (SDL_AtomicGet(&counter->waiters) > 0) shm_futex_wake(&counter->value);
+}
+
+internal Shm_Layout *shm_map(const char *name, bool create)
+{
+    s32 fd = shm_open(name, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0600);
+    if (fd < 0) {
+        fprintf(stderr, "[ERROR]: Could not open shared memory '%s' -> %s\n", name, strerror(errno));
+        return(0);
+    }
+
+    if (create && ftruncate(fd, sizeof(Shm_Layout)) != 0) {
+        fprintf(stderr, "[ERROR]: Could not size shared memory '%s' -> %s\n", name, strerror(errno));
+        close(fd);
+        return(0);
+    }
+
+    void *memory = mmap(0, sizeof(Shm_Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        fprintf(stderr, "[ERROR]: Could not map shared memory '%s' -> %s\n", name, strerror(errno));
+        return(0);
     }
+
+    return((Shm_Layout *) memory);
 }
 
-// @ToDo: lines->size and indexing is done through size_t, but
-// we're using signed 32 bit integer here and for line_index. Consider
-// using a pair or something? (C++ still won't allow to return multiple values...)
-internal void delete_point(s32 index, Line_Array *lines)
+internal void shm_reset(Shm_Header *header)
 {
-    if (lines->size == 3) return;
+    SDL_AtomicSet(&header->producer, 0);
+    SDL_AtomicSet(&header->closed, 0);
+    SDL_AtomicSet(&header->request_head.value, 0);
+    SDL_AtomicSet(&header->request_tail.value, 0);
+    SDL_AtomicSet(&header->result_head.value, 0);
+    SDL_AtomicSet(&header->result_tail.value, 0);
+}
 
-    size_t selected_prev = lines->data[index].prev;
-    size_t selected_next = lines->data[index].next;
-    
-    lines->data[selected_prev].next = selected_next;
-    lines->data[selected_next].prev = selected_prev;
-    lines->data[selected_prev].x1 = lines->data[selected_next].x0;
-    lines->data[selected_prev].y1 = lines->data[selected_next].y0;
+// @Note: A killed producer never sets 'closed'.
+internal bool shm_producer_gone(Shm_Header *header)
+{
+    pid_t pid = (pid_t) SDL_AtomicGet(&header->producer);
+    return(pid != 0 && kill(pid, 0) != 0 && errno == ESRCH);
+}
 
-    if (index != lines->size - 1) {
-        size_t last = lines->size - 1;
-        size_t last_prev = lines->data[last].prev;
-        size_t last_next = lines->data[last].next;
-        
-        lines->data[last_prev].next = index;
-        lines->data[last_next].prev = index;
-        lines->data[index] = lines->data[last]; 
+// @Note: Rasterizes whatever producers put into the request ring until SIGINT/SIGTERM, one
+// producer at a time.
+internal s32 run_shm_server(const char *name)
+{
+    Shm_Layout *shm = shm_map(name, true);
+    if (!shm) return(1);
+
+    signal(SIGINT, server_handle_signal);
+    signal(SIGTERM, server_handle_signal);
+
+    Shm_Header *header = &shm->header;
+    shm_reset(header);
+    header->rows = RECT_ROWS;
+    header->cols = RECT_COLS;
+    header->line_size = sizeof(Line);
+    header->slots = SHM_SLOTS;
+    header->slot_lines = SHM_SLOT_LINES;
+    header->version = SHM_VERSION;
+    header->magic = SHM_MAGIC;
+
+    Arena arena = {"shm"};
+    u32 served = 0;
+    u64 session_start = 0;
+    u64 session_end = 0;
+    u64 raster_ns = 0;
+    u32 tail = 0;
+
+    printf("[INFO]: Rasterizing from shared memory '%s', %zu bytes\n", name, sizeof(Shm_Layout));
+    fflush(stdout);
+
+    while (!server_stop_requested) {
+        u32 head = shm_counter_wait(&header->request_head, tail);
+        if (head == tail) {
+            bool done = SDL_AtomicGet(&header->closed) && SDL_AtomicGet(&header->producer);
+            if (done || shm_producer_gone(header)) {
+                f64 seconds = elapsed_ms(session_start, session_end) / 1000.0;
+                printf("[INFO]: Producer %s, %u jobs in %.2f s, %.0f jobs/s, raster avg %.2f us\n", done ? "done" : "went away",
+                       served, seconds, served / MAX(seconds, 1e-9), raster_ns / (f64) MAX(served, 1) / 1000.0);
+                fflush(stdout);
+
+                shm_reset(header);
+                served = 0;
+                raster_ns = 0;
+                tail = 0;
+            }
+            continue;
+        }
+
+        if (served == 0) session_start = SDL_GetPerformanceCounter();
+
+        for (; tail != head && !server_stop_requested; ++tail) {
+            // @Note: Needs a free result slot before the request can go.
+            u32 result_head = (u32) SDL_AtomicGet(&header->result_head.value);
+            u32 result_tail = (u32) SDL_AtomicGet(&header->result_tail.value);
+            while (result_head - result_tail == SHM_SLOTS && !server_stop_requested) {
+                result_tail = shm_counter_wait(&header->result_tail, result_tail);
+
+                // @Note: Nobody is going to read the results anymore, drop the rest of its
+                // requests so the producer gets noticed as gone once the ring looks empty.
+                if (result_head - result_tail == SHM_SLOTS && shm_producer_gone(header)) {
+                    head = tail = (u32) SDL_AtomicGet(&header->request_head.value);
+                    break;
+                }
+            }
+            if (server_stop_requested || tail == head) break;
+
+            Shm_Request *request = &shm->requests[tail % SHM_SLOTS];
+            Shm_Result *result = &shm->results[result_head % SHM_SLOTS];
+            arena_reset(&arena);
+
+            u64 start = SDL_GetPerformanceCounter();
+            Line_Array lines = {request->lines, (size_t) MIN(request->size, SHM_SLOT_LINES), SHM_SLOT_LINES, true};
+            Span_Sink sink = span_sink_mask(&result->mask);
+            Raster_Engine engine = request->engine < RASTER_ENGINE_COUNT ? (Raster_Engine) request->engine : RASTER_ENGINE_TILED;
+
+            // @Note: An empty request covers nothing, the slot's lines are whatever the last
+            // request left there.
+            if (lines.size == 0) memset(result->mask.words, 0, sizeof(result->mask.words));
+            else rasterize(engine, &lines, 1, &sink, &arena);
+            session_end = SDL_GetPerformanceCounter();
+            u64 ns = (u64) (elapsed_ms(start, session_end) * 1e6);
+
+            result->id = request->id;
+            result->lines = (u32) lines.size;
+            result->raster_ns = ns;
+            raster_ns += ns;
+            served += 1;
+
+            shm_counter_publish(&header->request_tail, tail + 1);
+            shm_counter_publish(&header->result_head, result_head + 1);
+        }
     }
-    
-    lines->size -= 1;
+
+    printf("[INFO]: Shutting down\n");
+    arena_free(&arena);
+    munmap(shm, sizeof(Shm_Layout));
+    shm_unlink(name);
+
+    return(0);
 }
 
-internal void render_draw_circle(SDL_Renderer *renderer, u32 cx, u32 cy, u32 r)
+// @Note: Sample producer and benchmark. Builds 'jobs' shapes right in the request slots (the
+// scene every time, or the '-diff' shapes without one), reads the masks back and checks every
+// SHM_CHECK_INTERVAL'th of them against rasterizing it here.
+internal s32 run_shm_producer(const char *name, u32 jobs, Line_Array *scene, Raster_Engine engine, u64 seed)
 {
-    u32 x = r;
-    u32 y = 0;
-    s32 p = 1 - r;
-    
-    SDL_RenderDrawLine(renderer, cx-r, cy, cx+r, cy);
-    
-    while (x >= y) {
-        y += 1;
-        
-        if (p <= 0) {
-            p += 2*y + 1;
-        } else {
-            x -= 1;
-            p += 2*y - 2*x + 1;
+    if (scene && scene->size > SHM_SLOT_LINES) {
+        fprintf(stderr, "[ERROR]: The scene has %zu lines, a slot takes %d\n", scene->size, SHM_SLOT_LINES);
+        return(1);
+    }
+
+    Shm_Layout *shm = shm_map(name, false);
+    if (!shm) return(1);
+
+    Shm_Header *header = &shm->header;
+    if (header->magic != SHM_MAGIC || header->version != SHM_VERSION ||
+        header->rows != RECT_ROWS || header->cols != RECT_COLS || header->line_size != sizeof(Line) ||
+        header->slots != SHM_SLOTS || header->slot_lines != SHM_SLOT_LINES) {
+        fprintf(stderr, "[ERROR]: '%s' isn't a rasterizer for a %dx%d grid built like this one\n", name, RECT_ROWS, RECT_COLS);
+        munmap(shm, sizeof(Shm_Layout));
+        return(1);
+    }
+
+    // @Note: The rasterizer may still be wrapping up the producer before us.
+    u64 attach_start = SDL_GetPerformanceCounter();
+    while (!SDL_AtomicCAS(&header->producer, 0, (s32) getpid())) {
+        if (elapsed_ms(attach_start, SDL_GetPerformanceCounter()) > 4 * SHM_WAIT_MS) {
+            fprintf(stderr, "[ERROR]: '%s' already has a producer\n", name);
+            munmap(shm, sizeof(Shm_Layout));
+            return(1);
         }
+        SDL_Delay(1);
+    }
 
-        SDL_RenderDrawLine(renderer, cx+x, cy-y, cx-x, cy-y);
-        SDL_RenderDrawLine(renderer, cx+x, cy+y, cx-x, cy+y);
-        SDL_RenderDrawLine(renderer, cx+y, cy-x, cx-y, cy-x);
-        SDL_RenderDrawLine(renderer, cx+y, cy+x, cx-y, cy+x);
+    // @Note: Big, keep it off the stack.
+    static Line_Array checked[SHM_SLOTS];
+    static Coverage_Mask expected;
+    Random_Series series = random_seed(seed);
+    u32 sent = 0;
+    u32 received = 0;
+    u32 mismatches = 0;
+    u64 lines_sent = 0;
+    u64 raster_ns = 0;
+    u64 start = SDL_GetPerformanceCounter();
+
+    while (received < jobs) {
+        u32 request_tail = (u32) SDL_AtomicGet(&header->request_tail.value);
+        while (sent < jobs && sent - request_tail < SHM_SLOTS) {
+            Shm_Request *request = &shm->requests[sent % SHM_SLOTS];
+            Line_Array lines = {request->lines, 0, SHM_SLOT_LINES, true};
+
+            if (scene) {
+                memcpy(lines.data, scene->data, scene->size * sizeof(Line));
+                lines.size = scene->size;
+            } else {
+                diff_make_shape((Diff_Shape) (sent % DIFF_SHAPE_COUNT), &series, &lines);
+                ERROR_EXIT(lines.data != request->lines, "[ERROR]: A shape outgrew its slot\n");
+            }
+
+            request->id = sent;
+            request->engine = engine;
+            request->size = lines.size;
+            lines_sent += lines.size;
+            if (sent % SHM_CHECK_INTERVAL == 0) line_array_copy(&checked[(sent / SHM_CHECK_INTERVAL) % SHM_SLOTS], &lines);
+
+            sent += 1;
+            shm_counter_publish(&header->request_head, sent);
+        }
+
+        u32 result_head = shm_counter_wait(&header->result_head, received);
+        for (; received != result_head; ++received) {
+            Shm_Result *result = &shm->results[received % SHM_SLOTS];
+            raster_ns += result->raster_ns;
+
+            if (result->id != received) {
+                if (mismatches == 0) fprintf(stderr, "[ERROR]: Expected the result of job %u, got %u\n", received, result->id);
+                mismatches += 1;
+            } else if (received % SHM_CHECK_INTERVAL == 0) {
+                arena_reset(&frame_arena);
+                Span_Sink sink = span_sink_mask(&expected);
+                rasterize(RASTER_ENGINE_TILED, &checked[(received / SHM_CHECK_INTERVAL) % SHM_SLOTS], 1, &sink, &frame_arena);
+
+                s32 x, y;
+                if (coverage_mask_first_difference(&expected, &result->mask, &x, &y)) {
+                    if (mismatches == 0) fprintf(stderr, "[ERROR]: Job %u differs at cell (%d, %d)\n", received, x, y);
+                    mismatches += 1;
+                }
+            }
+        }
+        shm_counter_publish(&header->result_tail, received);
     }
+
+    f64 seconds = elapsed_ms(start, SDL_GetPerformanceCounter()) / 1000.0;
+    printf("[INFO]: %u jobs in %.2f s, %.0f jobs/s, %.1f M lines/s, raster avg %.2f us, %u of %u checked jobs wrong\n",
+           received, seconds, received / MAX(seconds, 1e-9), lines_sent / MAX(seconds, 1e-9) / 1e6,
+           raster_ns / (f64) MAX(received, 1) / 1000.0, mismatches, (jobs + SHM_CHECK_INTERVAL - 1) / SHM_CHECK_INTERVAL);
+
+    SDL_AtomicSet(&header->closed, 1);
+    shm_futex_wake(&header->request_head.value);
+    munmap(shm, sizeof(Shm_Layout));
+    for (s32 i = 0; i < SHM_SLOTS; ++i) line_array_free(&checked[i]);
+
+    return(mismatches == 0 ? 0 : 1);
 }
 
-internal Render_Ctx create_render_context(u32 width, u32 height, const char *window_title)
+#else
+
+internal s32 run_server(const char *path, s32 worker_count)
 {
-    Render_Ctx context = {0};
+    UNUSED(path);
+    UNUSED(worker_count);
+    fprintf(stderr, "[ERROR]: Serving needs Unix domain sockets, not available on this platform\n");
+    return(1);
+}
 
-    ERROR_EXIT(SDL_Init(SDL_INIT_VIDEO) != 0, "[ERROR]: Could not initialize SDL2 -> %s\n", SDL_GetError());
+internal s32 run_client(const char *path, u32 jobs, Line_Array *scene, Raster_Engine engine, u64 seed)
+{
+    UNUSED(path);
+    UNUSED(jobs);
+    UNUSED(scene);
+    UNUSED(engine);
+    UNUSED(seed);
+    fprintf(stderr, "[ERROR]: Serving needs Unix domain sockets, not available on this platform\n");
+    return(1);
+}
 
-    context.window = SDL_CreateWindow(window_title,
-                                      SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                                      width, height,
-                                      SDL_WINDOW_SHOWN);
-    ERROR_EXIT(context.window == 0, "[ERROR]: Could not create SDL2 window");
+internal s32 run_shm_server(const char *name)
+{
+    UNUSED(name);
+    fprintf(stderr, "[ERROR]: Shared memory needs POSIX shm_open, not available on this platform\n");
+    return(1);
+}
 
-    context.renderer = SDL_CreateRenderer(context.window, -1, SDL_RENDERER_ACCELERATED);
-    ERROR_EXIT(context.renderer == 0, "[ERROR]: Could not create SDL2 renderer");
+internal s32 run_shm_producer(const char *name, u32 jobs, Line_Array *scene, Raster_Engine engine, u64 seed)
+{
+    UNUSED(name);
+    UNUSED(jobs);
+    UNUSED(scene);
+    UNUSED(engine);
+    UNUSED(seed);
+    fprintf(stderr, "[ERROR]: Shared memory needs POSIX shm_open, not available on this platform\n");
+    return(1);
+}
 
-    SDL_SetHint(SDL_HINT_MOUSE_FOCUS_CLICKTHROUGH, "1");
-    
-    return(context);
+#endif // RASTER_POSIX
+
+// @Note: Live geometry feed. Another process writes to stdin or a FIFO and the live loop applies
+// whatever arrived each frame before rasterizing once. Messages are framed the same way as the
+// server's (u32 size of what follows, u32 type, u32 id, payload), the id is ignored:
+//
+//   FEED_MESSAGE_MOVE      any number of (u32 vertex, s32 x, s32 y), moves the start of line
+//                          'vertex' and the end of the one before it, like dragging a handle
+//   FEED_MESSAGE_CONTOURS  u32 contours and the contours as in a raster request, replaces the shape
+//   FEED_MESSAGE_ADD       the same, appended to the shape
+//
+// Vertices are numbered the way the contours came in, the first point of the first contour
+// is 0. A move that repeats within a frame just overwrites the earlier one.
+#define FEED_BUFFER_SIZE (1024 * 1024)
+#define FEED_FRAME_BYTES (16 * 1024 * 1024)
+#define FEED_MOVE_SIZE 12
+
+enum Feed_Message {
+    FEED_MESSAGE_MOVE = 1,
+    FEED_MESSAGE_CONTOURS,
+    FEED_MESSAGE_ADD,
+};
+
+struct Feed {
+    s32 fd;
+    bool open;
+    u8 *buffer;
+    size_t capacity;
+    size_t used;
+
+    // @Note: Parsed into, then swapped with the shape, a broken message leaves the shape alone.
+    Line_Array incoming;
+
+    u64 messages;
+    u64 rejected;
+    u64 bytes;
+    u64 vertices;
+    u32 frames;
+    u32 vertices_max;
+    f64 apply_ms_max;
+};
+
+#ifdef RASTER_POSIX
+
+// @Note: Applies one message, false if it was malformed. Clears the selection when the shape's
+// layout changes, the vertex it pointed to may be gone.
+internal bool feed_apply(Feed *feed, App *app, u32 type, u8 *payload, size_t size, u32 *vertices)
+{
+    Line_Array *lines = &app->lines;
+    Byte_Reader reader = {payload, payload + size, true};
+
+    switch (type) {
+        case FEED_MESSAGE_MOVE: {
+            if (size % FEED_MOVE_SIZE != 0) return(false);
+            for (u8 *at = payload; at < payload + size; at += FEED_MOVE_SIZE) {
+                if (read_u32_le(at) >= lines->size) return(false);
+            }
+
+            for (u8 *at = payload; at < payload + size; at += FEED_MOVE_SIZE) {
+                u32 index = read_u32_le(at);
+                size_t connected_line = lines->data[index].prev;
+                lines->data[index].x0 = lines->data[connected_line].x1 = (s32) read_u32_le(at + 4);
+                lines->data[index].y0 = lines->data[connected_line].y1 = (s32) read_u32_le(at + 8);
+            }
+
+            *vertices += (u32) (size / FEED_MOVE_SIZE);
+        } break;
+
+        case FEED_MESSAGE_CONTOURS: {
+            // @Note: Nothing to replace the shape with isn't a shape, the editor needs at least one contour.
+            feed->incoming.size = 0;
+            if (!byte_reader_contours(&reader, &feed->incoming, &frame_arena) || reader.at != reader.end || feed->incoming.size == 0) return(false);
+
+            Line_Array swap = *lines;
+            *lines = feed->incoming;
+            feed->incoming = swap;
+
+            app->line_index = -1;
+            *vertices += (u32) lines->size;
+        } break;
+
+        case FEED_MESSAGE_ADD: {
+            size_t base = lines->size;
+            if (!byte_reader_contours(&reader, lines, &frame_arena)) return(false);
+            if (reader.at != reader.end) {
+                lines->size = base;
+                return(false);
+            }
+
+            app->line_index = -1;
+            *vertices += (u32) (lines->size - base);
+        } break;
+
+        default: return(false);
+    }
+
+    return(true);
 }
 
-internal void destroy_render_context(Render_Ctx *ctx)
+// @Note: "-" reads stdin. Opening a FIFO waits until the producer opens the other end.
+internal void feed_open(Feed *feed, const char *path)
 {
-    SDL_DestroyWindow(ctx->window);
-    SDL_DestroyRenderer(ctx->renderer);
+    if (strcmp(path, "-") == 0) {
+        feed->fd = STDIN_FILENO;
+    } else {
+        printf("[INFO]: Waiting for a writer on '%s'\n", path);
+        fflush(stdout);
+        feed->fd = open(path, O_RDONLY);
+        ERROR_EXIT(feed->fd < 0, "[ERROR]: Could not open '%s' for reading -> %s\n", path, strerror(errno));
+    }
 
-    SDL_Quit();
+    feed->capacity = FEED_BUFFER_SIZE;
+    feed->buffer = (u8 *) SDL_malloc(feed->capacity);
+    ERROR_EXIT(feed->buffer == 0, "[ERROR]: Out of memory for the feed buffer\n");
+    feed->open = true;
+}
+
+// @Note: Reads whatever the producer has written so far without ever blocking, at most
+// FEED_FRAME_BYTES a frame so a producer that's faster than us can't keep the frame from ending.
+// Returns true if the shape changed and needs rasterizing.
+internal bool feed_poll(Feed *feed, App *app)
+{
+    if (!feed->open) return(false);
+
+    u64 start = SDL_GetPerformanceCounter();
+    bool changed = false;
+    u32 vertices = 0;
+    size_t read_bytes = 0;
+
+    while (feed->open && read_bytes < FEED_FRAME_BYTES) {
+        struct pollfd readable = {feed->fd, POLLIN, 0};
+        if (poll(&readable, 1, 0) <= 0) break;
+
+        // @Note: Only grows for a message that doesn't fit, see below.
+        ssize_t got = read(feed->fd, feed->buffer + feed->used, feed->capacity - feed->used);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) {
+            if (got < 0) fprintf(stderr, "[ERROR]: Reading the feed failed -> %s\n", strerror(errno));
+            printf("[INFO]: Feed closed\n");
+            feed->open = false;
+            break;
+        }
+
+        feed->used += (size_t) got;
+        feed->bytes += (u64) got;
+        read_bytes += (size_t) got;
+
+        u8 *at = feed->buffer;
+        u8 *end = feed->buffer + feed->used;
+        while (end - at >= SERVER_HEADER_SIZE) {
+            u32 size = read_u32_le(at);
+            if (size < 8 || size - 8 > SERVER_MESSAGE_MAX) {
+                fprintf(stderr, "[ERROR]: Feed sent a %u byte message, giving up on it\n", size);
+                feed->open = false;
+                break;
+            }
+
+            if ((size_t) (end - at) < 4 + (size_t) size) break;
+
+            feed->messages += 1;
+            if (feed_apply(feed, app, read_u32_le(at + 4), at + SERVER_HEADER_SIZE, size - 8, &vertices)) changed = true;
+            else feed->rejected += 1;
+
+            at += 4 + size;
+        }
+
+        feed->used = (size_t) (end - at);
+        memmove(feed->buffer, at, feed->used);
+
+        if (feed->used >= SERVER_HEADER_SIZE) {
+            size_t needed = 4 + (size_t) read_u32_le(feed->buffer);
+            if (needed > feed->capacity) {
+                feed->buffer = (u8 *) SDL_realloc(feed->buffer, needed);
+                ERROR_EXIT(feed->buffer == 0, "[ERROR]: Out of memory for a %zu byte feed message\n", needed);
+                feed->capacity = needed;
+            }
+        }
+    }
+
+    if (changed) {
+        f64 apply_ms = elapsed_ms(start, SDL_GetPerformanceCounter());
+        feed->frames += 1;
+        feed->vertices += vertices;
+        feed->vertices_max = MAX(feed->vertices_max, vertices);
+        feed->apply_ms_max = MAX(feed->apply_ms_max, apply_ms);
+    }
+
+    return(changed);
+}
+
+internal void feed_close(Feed *feed)
+{
+    if (feed->fd > STDIN_FILENO) close(feed->fd);
+    SDL_free(feed->buffer);
+    line_array_free(&feed->incoming);
+
+    printf("[INFO]: Feed: %llu messages (%llu rejected), %llu bytes, %llu vertices over %u frames, at most %u in a frame, applying took at most %.3f ms\n",
+           (unsigned long long) feed->messages, (unsigned long long) feed->rejected, (unsigned long long) feed->bytes,
+           (unsigned long long) feed->vertices, feed->frames, feed->vertices_max, feed->apply_ms_max);
+}
+
+#else
+
+internal void feed_open(Feed *feed, const char *path)
+{
+    UNUSED(feed);
+    ERROR_EXIT(true, "[ERROR]: Can't read a feed from '%s', needs POSIX file descriptors\n", path);
+}
+
+internal bool feed_poll(Feed *feed, App *app)
+{
+    UNUSED(feed);
+    UNUSED(app);
+    return(false);
+}
+
+internal void feed_close(Feed *feed) { UNUSED(feed); }
+
+#endif // RASTER_POSIX
+
+internal void print_usage(const char *program)
+{
+    fprintf(stderr, "Usage: %s [-engine <name>] [-mode <name>] [-record <file>] [-feed <fifo or ->]\n", program);
+    fprintf(stderr, "       %s [-engine <name>] [-mode <name>] -replay <file> [-realtime] [-timings <file.csv>] [-golden <file>] [-no-alloc <warmup frames>]\n", program);
+    fprintf(stderr, "       Sessions and replays take [-video <file.y4m>] to save what gets shown as raw video\n");
+    fprintf(stderr, "       %s -diff <shapes> [-seed <n>]\n", program);
+    fprintf(stderr, "       %s -bench <runs> [-counters] [scene]\n", program);
+    fprintf(stderr, "       %s -serve <socket> [-workers <n>]\n", program);
+    fprintf(stderr, "       %s -client <socket> [-jobs <n>] [-engine <name>] [-seed <n>] [scene]\n", program);
+    fprintf(stderr, "       %s -shm-serve <name>\n", program);
+    fprintf(stderr, "       %s -shm-produce <name> [-jobs <n>] [-engine <name>] [-seed <n>] [scene]\n", program);
+    fprintf(stderr, "Every mode takes [-kernels <name>] to force a kernel variant, RASTER_KERNELS does the same\n");
+    fprintf(stderr, "Scene: [-scene <file> [-import-runs <n>]] or -generate <vertices> [-seed <n>] [-convexity <0..1>] [-intersections <0..1>]\n");
+    fprintf(stderr, "       [-aspect <w/h>] [-holes <n>] [-curves <0..1>]\n");
+    fprintf(stderr, "       [-out <file> [-binary]] saves the scene instead of showing it\n");
+    fprintf(stderr, "       .svg, .geojson, .json and .wkt scenes get imported\n");
+    fprintf(stderr, "       [-export <file.png|.ppm|.pgm> [-export-mode mask|aa|rgba] [-export-scale <pixels per cell>]] saves an image of it instead\n");
+}
+
+// @Note: Returns the index of 'name' in 'names' or -1.
+internal s32 find_name(const char **names, s32 count, const char *name)
+{
+    for (s32 i = 0; i < count; ++i) {
+        if (strcmp(names[i], name) == 0) return(i);
+    }
+
+    return(-1);
 }
 
 int main(int argc, char **argv)
 {
-    UNUSED(argc);
-    UNUSED(argv);
+    alloc_tracking_install();
+    
+    const char *record_path = 0;
+    const char *replay_path = 0;
+    const char *timings_path = 0;
+    const char *golden_path = 0;
+    bool realtime = false;
+    bool no_alloc = false;
+    Alloc_Check alloc_check = {};
+    s32 engine = RASTER_ENGINE_TILED;
+    s32 mode = RASTER_MODE_WORKER;
+    u32 diff_shapes = 0;
+    u64 seed = 1;
+    const char *scene_path = 0;
+    const char *out_path = 0;
+    bool binary = false;
+    u32 import_runs = 1;
+    const char *export_path = 0;
+    const char *video_path = 0;
+    s32 export_mode = EXPORT_MODE_RGBA;
+    s32 export_scale = 1;
+    Scene_Map scene_map_view = {};
+    u32 scene_color = FILLED_COLOR;
+    bool generate = false;
+    u32 bench_runs = 0;
+    bool counters = false;
+    const char *serve_path = 0;
+    const char *client_path = 0;
+    s32 workers = SDL_GetCPUCount();
+    u32 jobs = 10000;
+    const char *feed_path = 0;
+    const char *shm_serve_name = 0;
+    const char *shm_produce_name = 0;
+    const char *kernels_name = SDL_getenv("RASTER_KERNELS");
+    Scene_Params params = scene_params_default();
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "-replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "-timings") == 0 && i + 1 < argc) {
+            timings_path = argv[++i];
+        } else if (strcmp(argv[i], "-golden") == 0 && i + 1 < argc) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "-realtime") == 0) {
+            realtime = true;
+        } else if (strcmp(argv[i], "-no-alloc") == 0 && i + 1 < argc) {
+            no_alloc = true;
+            alloc_check.warmup_frames = (u32) strtoul(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-engine") == 0 && i + 1 < argc) {
+            engine = find_name(raster_engine_names, RASTER_ENGINE_COUNT, argv[++i]);
+        } else if (strcmp(argv[i], "-mode") == 0 && i + 1 < argc) {
+            mode = find_name(raster_mode_names, RASTER_MODE_COUNT, argv[++i]);
+        } else if (strcmp(argv[i], "-diff") == 0 && i + 1 < argc) {
+            diff_shapes = (u32) strtoul(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-scene") == 0 && i + 1 < argc) {
+            scene_path = argv[++i];
+        } else if (strcmp(argv[i], "-generate") == 0 && i + 1 < argc) {
+            generate = true;
+            params.vertices = (u32) strtoul(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-convexity") == 0 && i + 1 < argc) {
+            params.convexity = (f32) atof(argv[++i]);
+        } else if (strcmp(argv[i], "-intersections") == 0 && i + 1 < argc) {
+            params.intersections = (f32) atof(argv[++i]);
+        } else if (strcmp(argv[i], "-aspect") == 0 && i + 1 < argc) {
+            params.aspect = (f32) atof(argv[++i]);
+        } else if (strcmp(argv[i], "-holes") == 0 && i + 1 < argc) {
+            params.holes = (u32) strtoul(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-curves") == 0 && i + 1 < argc) {
+            params.curves = (f32) atof(argv[++i]);
+        } else if (strcmp(argv[i], "-bench") == 0 && i + 1 < argc) {
+            bench_runs = (u32) strtoul(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-counters") == 0) {
+            counters = true;
+        } else if (strcmp(argv[i], "-kernels") == 0 && i + 1 < argc) {
+            kernels_name = argv[++i];
+        } else if (strcmp(argv[i], "-out") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "-binary") == 0) {
+            binary = true;
+        } else if (strcmp(argv[i], "-import-runs") == 0 && i + 1 < argc) {
+            import_runs = (u32) strtoul(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-export") == 0 && i + 1 < argc) {
+            export_path = argv[++i];
+        } else if (strcmp(argv[i], "-export-mode") == 0 && i + 1 < argc) {
+            export_mode = find_name(export_mode_names, EXPORT_MODE_COUNT, argv[++i]);
+        } else if (strcmp(argv[i], "-export-scale") == 0 && i + 1 < argc) {
+            export_scale = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-video") == 0 && i + 1 < argc) {
+            video_path = argv[++i];
+        } else if (strcmp(argv[i], "-serve") == 0 && i + 1 < argc) {
+            serve_path = argv[++i];
+        } else if (strcmp(argv[i], "-workers") == 0 && i + 1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-client") == 0 && i + 1 < argc) {
+            client_path = argv[++i];
+        } else if (strcmp(argv[i], "-jobs") == 0 && i + 1 < argc) {
+            jobs = (u32) strtoul(argv[++i], 0, 10);
+        } else if (strcmp(argv[i], "-feed") == 0 && i + 1 < argc) {
+            feed_path = argv[++i];
+        } else if (strcmp(argv[i], "-shm-serve") == 0 && i + 1 < argc) {
+            shm_serve_name = argv[++i];
+        } else if (strcmp(argv[i], "-shm-produce") == 0 && i + 1 < argc) {
+            shm_produce_name = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (engine < 0 || mode < 0 || export_mode < 0 || export_scale < 1 || (export_path && export_format(export_path) == EXPORT_FORMAT_NONE) ||
+        !raster_kernels_select(kernels_name)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // @Note: Feed edits don't go through SDL events, a recording of them wouldn't replay the same.
+    if (record_path && feed_path) {
+        fprintf(stderr, "[ERROR]: -record can't be used with -feed, feed edits can't be recorded\n");
+        return 1;
+    }
 
+    if (diff_shapes > 0) return(run_differential_check(diff_shapes, seed));
+    if (serve_path) return(run_server(serve_path, workers));
+    if (shm_serve_name) return(run_shm_server(shm_serve_name));
+    
     SDL_Rect rects[RECT_ROWS * RECT_COLS] = {0};
-    SDL_Rect filled_rects[RECT_ROWS * RECT_COLS] = {0};
-    Line_Array lines = {0};
 
-    // @Note: This is a placeholder for now, just to start
-    // with some basic points.
-    {
-        line_array_add(&lines, RECT_ROWS/8, 20, RECT_ROWS/2, 10);
-        line_array_add(&lines, RECT_ROWS/2, 10, RECT_ROWS - 10, 30);
-        line_array_add(&lines, RECT_ROWS - 10, 30, RECT_ROWS/8, 20);
+    // @Note: Big, keep it off the stack.
+    static App app = {};
+    int exit_code = 0;
+    app.line_index = -1;
+
+    if (generate) {
+        scene_generate(&app.lines, &params, seed);
+        printf("[INFO]: Generated %zu lines from seed %llu\n", app.lines.size, (unsigned long long) seed);
+    } else if (scene_path && scene_file_is_binary(scene_path)) {
+        u64 start = SDL_GetPerformanceCounter();
+        ERROR_EXIT(!scene_open_binary(&scene_map_view, scene_path, &app.lines, &scene_color), "[ERROR]: '%s' is not a valid binary scene for this build\n", scene_path);
+
+        printf("[INFO]: Mapped %zu lines from '%s' in %.3f ms\n", app.lines.size, scene_path, elapsed_ms(start, SDL_GetPerformanceCounter()));
+    } else if (scene_path && import_format(scene_path) != IMPORT_NONE) {
+        ERROR_EXIT(!import_scene(scene_path, import_format(scene_path), &app.lines, import_runs), "[ERROR]: Could not read '%s'\n", scene_path);
+    } else if (scene_path) {
+        FILE *file = fopen(scene_path, "r");
+        ERROR_EXIT(file == 0, "[ERROR]: Could not open '%s' for reading\n", scene_path);
+        ERROR_EXIT(!line_array_read_contours(&app.lines, file), "[ERROR]: '%s' is not a valid contour file\n", scene_path);
+        fclose(file);
+        
+        printf("[INFO]: Loaded %zu lines from '%s'\n", app.lines.size, scene_path);
+    } else {
+        // @Note: This is a placeholder for now, just to start
+        // with some basic points.
+        Line_Array *lines = &app.lines;
+        line_array_add(lines, FIXED_FROM_CELLS(RECT_ROWS/8), FIXED_FROM_CELLS(20), FIXED_FROM_CELLS(RECT_ROWS/2), FIXED_FROM_CELLS(10));
+        line_array_add(lines, FIXED_FROM_CELLS(RECT_ROWS/2), FIXED_FROM_CELLS(10), FIXED_FROM_CELLS(RECT_ROWS - 10), FIXED_FROM_CELLS(30));
+        line_array_add(lines, FIXED_FROM_CELLS(RECT_ROWS - 10), FIXED_FROM_CELLS(30), FIXED_FROM_CELLS(RECT_ROWS/8), FIXED_FROM_CELLS(20));
+
+        line_array_connect(lines, 0, 1, 2);
+        line_array_connect(lines, 1, 2, 0);
+        line_array_connect(lines, 2, 0, 1);
+    }
+
+    if (out_path) {
+        FILE *file = fopen(out_path, binary ? "wb" : "w");
+        ERROR_EXIT(file == 0, "[ERROR]: Could not open '%s' for writing\n", out_path);
+        if (binary) ERROR_EXIT(!scene_write_binary(&app.lines, scene_color, file), "[ERROR]: Could not write '%s'\n", out_path);
+        else line_array_write_contours(&app.lines, file);
+        fclose(file);
+
+        printf("[INFO]: Saved scene to '%s'\n", out_path);
+        return 0;
+    }
+
+    if (export_path) {
+        export_writer_start(&app.exporter, (Export_Mode) export_mode, export_scale, scene_color);
+        export_writer_submit(&app.exporter, &app.lines, (Raster_Engine) engine, export_path);
+        export_writer_stop(&app.exporter);
+        return(app.exporter.failed > 0 ? 1 : 0);
+    }
 
-        line_array_connect(&lines, 0, 1, 2);
-        line_array_connect(&lines, 1, 2, 0);
-        line_array_connect(&lines, 2, 0, 1);
+    if (bench_runs > 0) {
+        run_benchmark(&app.lines, bench_runs, counters);
+        return 0;
     }
 
+    if (client_path) return(run_client(client_path, jobs, (generate || scene_path) ? &app.lines : 0, (Raster_Engine) engine, seed));
+    if (shm_produce_name) return(run_shm_producer(shm_produce_name, jobs, (generate || scene_path) ? &app.lines : 0, (Raster_Engine) engine, seed));
+
     // @Note: Create initial board.
     for (u32 row = 0; row < RECT_ROWS; ++row) {
         for (u32 col = 0; col < RECT_COLS; ++col) {
@@ -330,93 +7375,123 @@ int main(int argc, char **argv)
         }
     }
     
-    rasterize_shape(&lines, rects, filled_rects);
-    
     Render_Ctx context = create_render_context(WIDTH, HEIGHT, "A Window");
-    bool should_quit = false;
-    bool mouse_held = false;
-    s32 line_index = 0;
-    
-    u32 current_time = 0;
-    u32 previous_time = SDL_GetTicks();
+    Mask_Presenter presenter = {0};
+    mask_presenter_init(&presenter, context.renderer);
+    presenter.color = scene_color;
+
+    Raster_Ctx *raster = &app.raster;
+    raster->mode = (Raster_Mode) mode;
+    raster->engine = (Raster_Engine) engine;
+    raster->preview_factor = PREVIEW_FACTOR;
     
-    while (!should_quit) {
-        current_time = SDL_GetTicks();
-        u32 time_elapsed = current_time - previous_time;
-        previous_time = current_time;
+    raster_worker_start(&raster->worker);
+    raster_ctx_request(raster, &app.lines);
+    export_writer_start(&app.exporter, (Export_Mode) export_mode, export_scale, scene_color);
+
+    Video_Writer video = {};
+    if (video_path) {
+        video_open(&video, video_path, context.renderer);
+        app.video = &video;
+    }
+
+    if (replay_path) {
+        FILE *file = fopen(replay_path, "rb");
+        ERROR_EXIT(file == 0, "[ERROR]: Could not open '%s' for reading\n", replay_path);
+        ERROR_EXIT(!recording_read_header(file), "[ERROR]: '%s' is not a recording for a %dx%d grid\n", replay_path, RECT_ROWS, RECT_COLS);
+
+        FILE *timings_file = 0;
+        if (timings_path) {
+            timings_file = fopen(timings_path, "w");
+            ERROR_EXIT(timings_file == 0, "[ERROR]: Could not open '%s' for writing\n", timings_path);
+        }
         
-        SDL_Event e = {0};
-        while (SDL_PollEvent(&e)) {
-            switch (e.type) {
-                case SDL_QUIT: {
-                    should_quit = true;
-                } break;
-
-                case SDL_MOUSEBUTTONDOWN: {
-                    if (e.button.button == SDL_BUTTON_LEFT) {
-                        mouse_held = true;
-                        line_index = get_index_of_selected_origin(e.button.x, e.button.y, &lines);
-                    } else if (e.button.button == SDL_BUTTON_RIGHT) {
-                        line_index = get_index_of_selected_origin(e.button.x, e.button.y, &lines);
-
-                        if (line_index == -1) add_new_point(e.button.x, e.button.y, &lines);
-                        else delete_point(line_index, &lines);
-                        
-                        rasterize_shape(&lines, rects, filled_rects);
-                    }
-                } break;
- 
-                case SDL_MOUSEBUTTONUP: {
-                    if (e.button.button == SDL_BUTTON_LEFT) mouse_held = false;
-                    line_index = -1;
-                } break;
-
-                case SDL_MOUSEMOTION: {
-                    if (mouse_held && line_index != -1) {
-                        u32 x = (u32) (((f32) e.motion.x/WIDTH) * RECT_ROWS);
-                        u32 y = (u32) (((f32) e.motion.y/HEIGHT) * RECT_COLS);
-                        
-                        if ((x > 0.0f && x < RECT_ROWS) && (y > 0.0f && y < RECT_COLS)) {
-                            size_t connected_line = lines.data[line_index].prev;
-                            lines.data[line_index].x0 = lines.data[connected_line].x1 = x;
-                            lines.data[line_index].y0 = lines.data[connected_line].y1 = y;
-                        
-                            rasterize_shape(&lines, rects, filled_rects);
-                        }
-                    }
-                } break;
-            }
+        Golden golden = {};
+        if (golden_path) golden_open(&golden, golden_path);
+        
+        bool replayed = replay_recording(file, realtime, timings_file, golden_path ? &golden : 0, no_alloc ? &alloc_check : 0, &context, &presenter, rects, &app);
+        
+        if (timings_file) fclose(timings_file);
+        if (golden.file) fclose(golden.file);
+        fclose(file);
+
+        if (!replayed || golden.failed) exit_code = 1;
+        else if (golden_path && !golden.writing) printf("[INFO]: Every frame matches the golden masks\n");
+
+        if (alloc_check.failed_frames > 0) {
+            fprintf(stderr, "[ERROR]: %u frames allocated while dragging after %u warm-up frames\n", alloc_check.failed_frames, alloc_check.warmup_frames);
+            exit_code = 1;
+        } else if (no_alloc) {
+            printf("[INFO]: Nothing got allocated while dragging after %u warm-up frames\n", alloc_check.warmup_frames);
+        }
+    } else {
+        if (record_path) {
+            app.recording = fopen(record_path, "wb");
+            ERROR_EXIT(app.recording == 0, "[ERROR]: Could not open '%s' for writing\n", record_path);
+            recording_write_header(app.recording);
         }
 
-        SDL_SetRenderDrawColor(context.renderer, 18, 18, 18, 255);
-        SDL_RenderClear(context.renderer);
+        Feed feed = {};
+        if (feed_path) feed_open(&feed, feed_path);
         
-        // @Note: Banana-cakes
-        for (u32 i = 0; i < RECT_ROWS * RECT_COLS; ++i) {
-            SDL_SetRenderDrawColor(context.renderer, 80, 80, 80, 255);
-            SDL_RenderDrawRect(context.renderer, &rects[i]);
+        u32 start_time = SDL_GetTicks();
+        u32 current_time = 0;
+        u32 previous_time = start_time;
+        u32 last_stats_time = 0;
+    
+        while (!app.should_quit) {
+            current_time = SDL_GetTicks();
+            u32 time_elapsed = current_time - previous_time;
+            previous_time = current_time;
+            raster->now = current_time - start_time;
+            arena_reset(&frame_arena);
 
-            SDL_SetRenderDrawColor(context.renderer, 0, 120, 0, 255);
-            SDL_RenderFillRect(context.renderer, &filled_rects[i]);
-        }
+            if (app.recording) {
+                Record frame = {};
+                frame.type = RECORD_FRAME;
+                frame.a = (s32) raster->now;
+                recording_write(app.recording, frame);
+            }
+        
+            alloc_phase = ALLOC_PHASE_EVENTS;
+            SDL_Event e = {0};
+            while (SDL_PollEvent(&e)) {
+                app_handle_event(&app, &e);
+            }
+
+            // @Note: Everything the feed sent this frame becomes one rasterization.
+            if (feed_poll(&feed, &app)) raster_ctx_request(raster, &app.lines);
 
-        for (u32 i = 0; i < lines.size; ++i) {
-            u32 x0 = lines.data[i].x0 * RECT_RES;
-            u32 y0 = lines.data[i].y0 * RECT_RES;
-            u32 x1 = lines.data[i].x1 * RECT_RES;
-            u32 y1 = lines.data[i].y1 * RECT_RES;
+            alloc_phase = ALLOC_PHASE_RASTER;
+            raster_ctx_update(raster, &app.lines, app.mouse_held && app.line_index != -1);
+        
+            alloc_phase = ALLOC_PHASE_OTHER;
+            if (current_time - last_stats_time >= STATS_INTERVAL_MS) {
+                report_stats(&context, raster, &presenter, &app.allocs);
+                last_stats_time = current_time;
+            }
 
-            SDL_SetRenderDrawColor(context.renderer, 255, 0, 0, 255);
+            alloc_phase = ALLOC_PHASE_PRESENT;
+            render_frame(&context, &presenter, rects, &app);
             
-            SDL_RenderDrawLine(context.renderer, x0, y0, x1, y1);
-            render_draw_circle(context.renderer, x0, y0, CIRCLE_RADIUS);
+            alloc_phase = ALLOC_PHASE_OTHER;
+            app.allocs = alloc_frame_end();
+            if (time_elapsed < MS_PER_FRAME) SDL_Delay(MS_PER_FRAME - time_elapsed);
         }
 
-        SDL_RenderPresent(context.renderer);
-        if (time_elapsed < MS_PER_FRAME) SDL_Delay(MS_PER_FRAME - time_elapsed);
+        if (app.recording) fclose(app.recording);
+        if (feed_path) feed_close(&feed);
     }
 
+    raster_worker_stop(&raster->worker);
+    export_writer_stop(&app.exporter);
+    if (app.video) video_close(app.video);
+    line_array_free(&raster->incremental.lines);
+    line_array_free(&app.lines);
+    scene_unmap(&scene_map_view);
+    arena_free(&frame_arena);
+    SDL_DestroyTexture(presenter.texture);
     destroy_render_context(&context);
 
-    return 0;
+    return(exit_code);
 }
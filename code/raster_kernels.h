@@ -0,0 +1,119 @@
+#ifndef RASTER_KERNELS_H
+#define RASTER_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint64_t u64;
+typedef uint32_t u32;
+typedef uint8_t  u8;
+typedef int32_t  s32;
+typedef int64_t  s64;
+typedef float    f32;
+typedef double   f64;
+
+#define internal static
+#define global static
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RASTER_KERNELS_X86
+#endif
+
+// @Note: Every variant lives in its own translation unit compiled with the same flags as the
+// rest, GCC and Clang get the instruction set per function instead. MSVC lets us use any
+// intrinsic without that.
+#if defined(__GNUC__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+#define TILE_GROUP_LINES 32
+
+// @Note: A group of lines laid out for the crossing kernel, line 'i' of the group is lane 'i'.
+// Only the lanes a kernel gets asked about have to be filled in.
+struct Line_Group {
+    s32 x0[TILE_GROUP_LINES];
+    s32 y0[TILE_GROUP_LINES];
+    s32 x1[TILE_GROUP_LINES];
+    s32 y1[TILE_GROUP_LINES];
+};
+
+// @Note: Returns the subset of 'lanes' whose line is hit by the ray going from the sample (x, y)
+// towards negative x. Same test as 'ray_hits_line_fixed', exact on integers.
+typedef u32 Crossings_Kernel(const Line_Group *group, u32 lanes, s32 x, s32 y);
+
+// @Note: out[i] = a[i] ^ b[i], returns how many bits are set over all of 'out'.
+typedef u32 Xor_Popcount_Kernel(const u64 *a, const u64 *b, u64 *out, size_t words);
+
+// @Note: Texels [x_first, x_last] of a row get 'color' where the row's mask bit is set and zero
+// where it isn't. 'pixels' points at the start of the row.
+typedef void Fill_Texels_Kernel(const u64 *row, s32 x_first, s32 x_last, u32 *pixels, u32 color);
+
+// @Note: Two rows of ARGB pixels to BT.601 studio range YUV 4:2:0. Both rows get their luma,
+// the chroma is at half width and comes from the average of each 2x2 block. 'width' is even.
+typedef void Yuv420_Rows_Kernel(const u32 *row0, const u32 *row1, s32 width, u8 *luma0, u8 *luma1, u8 *u, u8 *v);
+
+// @Note: For the kernels' own tails, no popcount instruction needed.
+internal inline u32 kernel_popcount64(u64 x)
+{
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    
+    return((u32) ((x * 0x0101010101010101ull) >> 56));
+}
+
+internal inline u32 kernel_texel(const u64 *row, s32 x, u32 color)
+{
+    return(((row[x / 64] >> (x % 64)) & 1) ? color : 0);
+}
+
+// @Note: 8 bit fixed point coefficients, every variant has to come out the same to the bit. The
+// sums fit 16 bits, luma unsigned and chroma signed.
+internal inline u8 kernel_luma(u32 pixel)
+{
+    s32 r = (s32) ((pixel >> 16) & 0xFF);
+    s32 g = (s32) ((pixel >> 8) & 0xFF);
+    s32 b = (s32) (pixel & 0xFF);
+
+    return((u8) (((66 * r + 129 * g + 25 * b + 128) >> 8) + 16));
+}
+
+internal inline void kernel_chroma(u32 p00, u32 p01, u32 p10, u32 p11, u8 *u, u8 *v)
+{
+    s32 r = (s32) ((((p00 >> 16) & 0xFF) + ((p01 >> 16) & 0xFF) + ((p10 >> 16) & 0xFF) + ((p11 >> 16) & 0xFF) + 2) >> 2);
+    s32 g = (s32) ((((p00 >> 8) & 0xFF) + ((p01 >> 8) & 0xFF) + ((p10 >> 8) & 0xFF) + ((p11 >> 8) & 0xFF) + 2) >> 2);
+    s32 b = (s32) (((p00 & 0xFF) + (p01 & 0xFF) + (p10 & 0xFF) + (p11 & 0xFF) + 2) >> 2);
+
+    *u = (u8) (((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    *v = (u8) (((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+}
+
+internal inline void kernel_yuv420_pair(const u32 *row0, const u32 *row1, s32 x, u8 *luma0, u8 *luma1, u8 *u, u8 *v)
+{
+    luma0[x] = kernel_luma(row0[x]);
+    luma0[x + 1] = kernel_luma(row0[x + 1]);
+    luma1[x] = kernel_luma(row1[x]);
+    luma1[x + 1] = kernel_luma(row1[x + 1]);
+    kernel_chroma(row0[x], row0[x + 1], row1[x], row1[x + 1], &u[x / 2], &v[x / 2]);
+}
+
+struct Raster_Kernels {
+    const char *name;
+    Crossings_Kernel *crossings;
+    Xor_Popcount_Kernel *xor_popcount;
+    Fill_Texels_Kernel *fill_texels;
+    Yuv420_Rows_Kernel *yuv420_rows;
+};
+
+extern const Raster_Kernels raster_kernels_scalar;
+
+#ifdef RASTER_KERNELS_X86
+extern const Raster_Kernels raster_kernels_sse2;
+extern const Raster_Kernels raster_kernels_sse41;
+extern const Raster_Kernels raster_kernels_avx2;
+extern const Raster_Kernels raster_kernels_avx512;
+#endif
+
+#endif // RASTER_KERNELS_H
@@ -0,0 +1,190 @@
+#include "raster_kernels.h"
+
+#ifdef RASTER_KERNELS_X86
+#include <immintrin.h>
+
+// @Note: Four 64 bit products at a time, with 64 bit compares we don't need the negation trick.
+KERNEL_TARGET("avx2")
+internal inline u32 misses_avx2(__m128i a, __m128i b, __m128i c, __m128i d, __m128i down)
+{
+    __m256i lhs = _mm256_mul_epi32(_mm256_cvtepi32_epi64(a), _mm256_cvtepi32_epi64(b));
+    __m256i rhs = _mm256_mul_epi32(_mm256_cvtepi32_epi64(c), _mm256_cvtepi32_epi64(d));
+    __m256i up_miss = _mm256_cmpgt_epi64(lhs, rhs);
+    __m256i down_miss = _mm256_cmpgt_epi64(rhs, lhs);
+    __m256i miss = _mm256_blendv_epi8(up_miss, down_miss, _mm256_cvtepi32_epi64(down));
+
+    return((u32) _mm256_movemask_pd(_mm256_castsi256_pd(miss)));
+}
+
+KERNEL_TARGET("avx2")
+internal u32 crossings_avx2(const Line_Group *group, u32 lanes, s32 x, s32 y)
+{
+    __m256i vx = _mm256_set1_epi32(x);
+    __m256i vy = _mm256_set1_epi32(y);
+    u32 hits = 0;
+
+    for (u32 i = 0; i < TILE_GROUP_LINES; i += 8) {
+        u32 chunk = (lanes >> i) & 0xFF;
+        if (chunk == 0) continue;
+
+        __m256i x0 = _mm256_loadu_si256((const __m256i *) &group->x0[i]);
+        __m256i y0 = _mm256_loadu_si256((const __m256i *) &group->y0[i]);
+        __m256i x1 = _mm256_loadu_si256((const __m256i *) &group->x1[i]);
+        __m256i y1 = _mm256_loadu_si256((const __m256i *) &group->y1[i]);
+
+        __m256i span = _mm256_xor_si256(_mm256_cmpgt_epi32(y0, vy), _mm256_cmpgt_epi32(y1, vy));
+        chunk &= (u32) _mm256_movemask_ps(_mm256_castsi256_ps(span));
+        if (chunk == 0) continue;
+
+        __m256i a = _mm256_sub_epi32(vy, y0);
+        __m256i b = _mm256_sub_epi32(x1, x0);
+        __m256i c = _mm256_sub_epi32(vx, x0);
+        __m256i d = _mm256_sub_epi32(y1, y0);
+        __m256i down = _mm256_cmpgt_epi32(y0, y1);
+
+        u32 misses = misses_avx2(_mm256_castsi256_si128(a), _mm256_castsi256_si128(b), _mm256_castsi256_si128(c),
+                                 _mm256_castsi256_si128(d), _mm256_castsi256_si128(down));
+        misses |= misses_avx2(_mm256_extracti128_si256(a, 1), _mm256_extracti128_si256(b, 1), _mm256_extracti128_si256(c, 1),
+                              _mm256_extracti128_si256(d, 1), _mm256_extracti128_si256(down, 1)) << 4;
+
+        hits |= (chunk & ~misses) << i;
+    }
+
+    return(hits);
+}
+
+KERNEL_TARGET("avx2")
+internal u32 xor_popcount_avx2(const u64 *a, const u64 *b, u64 *out, size_t words)
+{
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low = _mm256_set1_epi8(0x0F);
+    
+    __m256i total = _mm256_setzero_si256();
+    size_t i = 0;
+    
+    for (; i + 4 <= words; i += 4) {
+        __m256i x = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) &a[i]), _mm256_loadu_si256((const __m256i *) &b[i]));
+        _mm256_storeu_si256((__m256i *) &out[i], x);
+
+        __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low)),
+                                         _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), low)));
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+    }
+
+    u64 sums[4];
+    _mm256_storeu_si256((__m256i *) sums, total);
+    u32 count = (u32) (sums[0] + sums[1] + sums[2] + sums[3]);
+
+    for (; i < words; ++i) {
+        out[i] = a[i] ^ b[i];
+        count += kernel_popcount64(out[i]);
+    }
+
+    return(count);
+}
+
+KERNEL_TARGET("avx2")
+internal void fill_texels_avx2(const u64 *row, s32 x_first, s32 x_last, u32 *pixels, u32 color)
+{
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i vcolor = _mm256_set1_epi32((int) color);
+    
+    s32 x = x_first;
+    for (; x <= x_last && x % 8 != 0; ++x) pixels[x] = kernel_texel(row, x, color);
+    
+    for (; x + 7 <= x_last; x += 8) {
+        __m256i bits = _mm256_set1_epi32((int) ((row[x / 64] >> (x % 64)) & 0xFF));
+        __m256i filled = _mm256_cmpeq_epi32(_mm256_and_si256(bits, lane_bits), lane_bits);
+        _mm256_storeu_si256((__m256i *) &pixels[x], _mm256_and_si256(filled, vcolor));
+    }
+
+    for (; x <= x_last; ++x) pixels[x] = kernel_texel(row, x, color);
+}
+
+// @Note: Sixteen pixels into one 16 bit lane per pixel for each channel. Packs work within the
+// 128 bit halves, the permute puts the 64 bit pieces back in order.
+KERNEL_TARGET("avx2")
+internal inline void channels_avx2(const u32 *pixels, __m256i *r, __m256i *g, __m256i *b)
+{
+    const __m256i low = _mm256_set1_epi32(0xFF);
+    __m256i p0 = _mm256_loadu_si256((const __m256i *) pixels);
+    __m256i p1 = _mm256_loadu_si256((const __m256i *) (pixels + 8));
+
+    *r = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(p0, 16), low), _mm256_and_si256(_mm256_srli_epi32(p1, 16), low));
+    *g = _mm256_packs_epi32(_mm256_and_si256(_mm256_srli_epi32(p0, 8), low), _mm256_and_si256(_mm256_srli_epi32(p1, 8), low));
+    *b = _mm256_packs_epi32(_mm256_and_si256(p0, low), _mm256_and_si256(p1, low));
+    *r = _mm256_permute4x64_epi64(*r, _MM_SHUFFLE(3, 1, 2, 0));
+    *g = _mm256_permute4x64_epi64(*g, _MM_SHUFFLE(3, 1, 2, 0));
+    *b = _mm256_permute4x64_epi64(*b, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+// @Note: The sum only fits 16 bits unsigned, the wrapping adds and the logical shift keep it
+// that way.
+KERNEL_TARGET("avx2")
+internal inline __m256i luma_avx2(__m256i r, __m256i g, __m256i b)
+{
+    __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(66)), _mm256_mullo_epi16(g, _mm256_set1_epi16(129)));
+    sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(25)), _mm256_set1_epi16(128)));
+
+    return(_mm256_add_epi16(_mm256_srli_epi16(sum, 8), _mm256_set1_epi16(16)));
+}
+
+// @Note: Averages of the 2x2 blocks of two rows of 32 pixels, 'lo' having the first 16 of each.
+KERNEL_TARGET("avx2")
+internal inline __m256i average_avx2(__m256i row0_lo, __m256i row0_hi, __m256i row1_lo, __m256i row1_hi)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i lo = _mm256_madd_epi16(_mm256_add_epi16(row0_lo, row1_lo), ones);
+    __m256i hi = _mm256_madd_epi16(_mm256_add_epi16(row0_hi, row1_hi), ones);
+    __m256i sums = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+
+    return(_mm256_srli_epi16(_mm256_add_epi16(sums, _mm256_set1_epi16(2)), 2));
+}
+
+KERNEL_TARGET("avx2")
+internal inline __m128i chroma_avx2(__m256i r, __m256i g, __m256i b, s32 kr, s32 kg, s32 kb)
+{
+    __m256i sum = _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16((short) kr)), _mm256_mullo_epi16(g, _mm256_set1_epi16((short) kg)));
+    sum = _mm256_add_epi16(sum, _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16((short) kb)), _mm256_set1_epi16(128)));
+    sum = _mm256_add_epi16(_mm256_srai_epi16(sum, 8), _mm256_set1_epi16(128));
+
+    __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+    return(_mm256_castsi256_si128(bytes));
+}
+
+KERNEL_TARGET("avx2")
+internal void yuv420_rows_avx2(const u32 *row0, const u32 *row1, s32 width, u8 *luma0, u8 *luma1, u8 *u, u8 *v)
+{
+    s32 x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i r0[2], g0[2], b0[2], r1[2], g1[2], b1[2];
+        for (s32 half = 0; half < 2; ++half) {
+            channels_avx2(row0 + x + 16 * half, &r0[half], &g0[half], &b0[half]);
+            channels_avx2(row1 + x + 16 * half, &r1[half], &g1[half], &b1[half]);
+        }
+
+        __m256i y0 = _mm256_packus_epi16(luma_avx2(r0[0], g0[0], b0[0]), luma_avx2(r0[1], g0[1], b0[1]));
+        __m256i y1 = _mm256_packus_epi16(luma_avx2(r1[0], g1[0], b1[0]), luma_avx2(r1[1], g1[1], b1[1]));
+        _mm256_storeu_si256((__m256i *) (luma0 + x), _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256((__m256i *) (luma1 + x), _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3, 1, 2, 0)));
+
+        __m256i r = average_avx2(r0[0], r0[1], r1[0], r1[1]);
+        __m256i g = average_avx2(g0[0], g0[1], g1[0], g1[1]);
+        __m256i b = average_avx2(b0[0], b0[1], b1[0], b1[1]);
+        _mm_storeu_si128((__m128i *) (u + x / 2), chroma_avx2(r, g, b, -38, -74, 112));
+        _mm_storeu_si128((__m128i *) (v + x / 2), chroma_avx2(r, g, b, 112, -94, -18));
+    }
+
+    for (; x < width; x += 2) kernel_yuv420_pair(row0, row1, x, luma0, luma1, u, v);
+}
+
+extern const Raster_Kernels raster_kernels_avx2 = {
+    "avx2",
+    crossings_avx2,
+    xor_popcount_avx2,
+    fill_texels_avx2,
+    yuv420_rows_avx2,
+};
+
+#endif // RASTER_KERNELS_X86
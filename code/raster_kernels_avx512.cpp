@@ -0,0 +1,201 @@
+#include "raster_kernels.h"
+
+#ifdef RASTER_KERNELS_X86
+
+// @Note: GCC 12 reports '__Y' as maybe uninitialized inside _mm512_srli_epi64 once it's inlined
+// here, that's avx512fintrin.h's own _mm512_undefined_epi32, a false positive. Only this file.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#include <immintrin.h>
+
+// @Note: Only AVX-512F, that's all 'SDL_HasAVX512F' tells us about. Comparisons go straight
+// into mask registers so there are no movemasks and no blends.
+
+KERNEL_TARGET("avx512f")
+internal inline u32 misses_avx512(__m256i a, __m256i b, __m256i c, __m256i d, __mmask8 down)
+{
+    __m512i lhs = _mm512_mul_epi32(_mm512_cvtepi32_epi64(a), _mm512_cvtepi32_epi64(b));
+    __m512i rhs = _mm512_mul_epi32(_mm512_cvtepi32_epi64(c), _mm512_cvtepi32_epi64(d));
+    __mmask8 up_miss = _mm512_cmpgt_epi64_mask(lhs, rhs);
+    __mmask8 down_miss = _mm512_cmpgt_epi64_mask(rhs, lhs);
+
+    return((u32) ((up_miss & ~down) | (down_miss & down)) & 0xFF);
+}
+
+KERNEL_TARGET("avx512f")
+internal u32 crossings_avx512(const Line_Group *group, u32 lanes, s32 x, s32 y)
+{
+    __m512i vx = _mm512_set1_epi32(x);
+    __m512i vy = _mm512_set1_epi32(y);
+    u32 hits = 0;
+
+    for (u32 i = 0; i < TILE_GROUP_LINES; i += 16) {
+        u32 chunk = (lanes >> i) & 0xFFFF;
+        if (chunk == 0) continue;
+
+        __m512i x0 = _mm512_loadu_si512(&group->x0[i]);
+        __m512i y0 = _mm512_loadu_si512(&group->y0[i]);
+        __m512i x1 = _mm512_loadu_si512(&group->x1[i]);
+        __m512i y1 = _mm512_loadu_si512(&group->y1[i]);
+
+        chunk &= (u32) (_mm512_cmpgt_epi32_mask(y0, vy) ^ _mm512_cmpgt_epi32_mask(y1, vy));
+        if (chunk == 0) continue;
+
+        __m512i a = _mm512_sub_epi32(vy, y0);
+        __m512i b = _mm512_sub_epi32(x1, x0);
+        __m512i c = _mm512_sub_epi32(vx, x0);
+        __m512i d = _mm512_sub_epi32(y1, y0);
+        u32 down = (u32) _mm512_cmpgt_epi32_mask(y0, y1);
+
+        u32 misses = misses_avx512(_mm512_castsi512_si256(a), _mm512_castsi512_si256(b), _mm512_castsi512_si256(c),
+                                   _mm512_castsi512_si256(d), (__mmask8) down);
+        misses |= misses_avx512(_mm512_extracti64x4_epi64(a, 1), _mm512_extracti64x4_epi64(b, 1), _mm512_extracti64x4_epi64(c, 1),
+                                _mm512_extracti64x4_epi64(d, 1), (__mmask8) (down >> 8)) << 8;
+
+        hits |= (chunk & ~misses) << i;
+    }
+
+    return(hits);
+}
+
+// @Note: No byte shuffles or sums without AVX-512BW, counts bits the SWAR way on 64 bit lanes.
+KERNEL_TARGET("avx512f")
+internal u32 xor_popcount_avx512(const u64 *a, const u64 *b, u64 *out, size_t words)
+{
+    const __m512i m1 = _mm512_set1_epi64(0x5555555555555555ll);
+    const __m512i m2 = _mm512_set1_epi64(0x3333333333333333ll);
+    const __m512i m4 = _mm512_set1_epi64(0x0F0F0F0F0F0F0F0Fll);
+    const __m512i m7 = _mm512_set1_epi64(0x7F);
+    
+    __m512i total = _mm512_setzero_si512();
+    size_t i = 0;
+    
+    for (; i + 8 <= words; i += 8) {
+        __m512i x = _mm512_xor_si512(_mm512_loadu_si512(&a[i]), _mm512_loadu_si512(&b[i]));
+        _mm512_storeu_si512(&out[i], x);
+
+        x = _mm512_sub_epi64(x, _mm512_and_si512(_mm512_srli_epi64(x, 1), m1));
+        x = _mm512_add_epi64(_mm512_and_si512(x, m2), _mm512_and_si512(_mm512_srli_epi64(x, 2), m2));
+        x = _mm512_and_si512(_mm512_add_epi64(x, _mm512_srli_epi64(x, 4)), m4);
+        x = _mm512_add_epi64(x, _mm512_srli_epi64(x, 8));
+        x = _mm512_add_epi64(x, _mm512_srli_epi64(x, 16));
+        x = _mm512_add_epi64(x, _mm512_srli_epi64(x, 32));
+        total = _mm512_add_epi64(total, _mm512_and_si512(x, m7));
+    }
+
+    // @Note: Summed by hand, GCC 12 warns about the undefined vector _mm512_reduce_add_epi64
+    // starts from.
+    u64 lanes[8];
+    _mm512_storeu_si512(lanes, total);
+    u32 count = 0;
+    for (s32 lane = 0; lane < 8; ++lane) count += (u32) lanes[lane];
+
+    for (; i < words; ++i) {
+        out[i] = a[i] ^ b[i];
+        count += kernel_popcount64(out[i]);
+    }
+
+    return(count);
+}
+
+KERNEL_TARGET("avx512f")
+internal void fill_texels_avx512(const u64 *row, s32 x_first, s32 x_last, u32 *pixels, u32 color)
+{
+    const __m512i vcolor = _mm512_set1_epi32((int) color);
+    
+    s32 x = x_first;
+    for (; x <= x_last && x % 16 != 0; ++x) pixels[x] = kernel_texel(row, x, color);
+    
+    for (; x + 15 <= x_last; x += 16) {
+        __mmask16 filled = (__mmask16) ((row[x / 64] >> (x % 64)) & 0xFFFF);
+        _mm512_storeu_si512(&pixels[x], _mm512_maskz_mov_epi32(filled, vcolor));
+    }
+
+    for (; x <= x_last; ++x) pixels[x] = kernel_texel(row, x, color);
+}
+
+// @Note: No 16 bit lanes without AVX-512BW, so everything stays 32 bits wide and the
+// narrowing stores go straight to bytes.
+KERNEL_TARGET("avx512f")
+internal inline __m512i channel_avx512(__m512i pixels, u32 shift)
+{
+    return(_mm512_and_si512(_mm512_srli_epi32(pixels, shift), _mm512_set1_epi32(0xFF)));
+}
+
+// @Note: Red and blue go through one multiply, with red in the high half of the lane times
+// 66 + (25 << 16) the high half ends up with 66 * r + 25 * b. The low half's 66 * b never
+// carries into it.
+KERNEL_TARGET("avx512f")
+internal inline __m128i luma_avx512(__m512i pixels)
+{
+    __m512i red_blue = _mm512_and_si512(pixels, _mm512_set1_epi32(0x00FF00FF));
+    __m512i sum = _mm512_srli_epi32(_mm512_mullo_epi32(red_blue, _mm512_set1_epi32(66 + (25 << 16))), 16);
+    sum = _mm512_add_epi32(sum, _mm512_mullo_epi32(channel_avx512(pixels, 8), _mm512_set1_epi32(129)));
+    sum = _mm512_add_epi32(sum, _mm512_set1_epi32(128));
+
+    return(_mm512_cvtepi32_epi8(_mm512_add_epi32(_mm512_srli_epi32(sum, 8), _mm512_set1_epi32(16))));
+}
+
+// @Note: Average of one channel over the 2x2 blocks, the even and odd pixels of both rows.
+KERNEL_TARGET("avx512f")
+internal inline __m512i average_avx512(__m512i even0, __m512i odd0, __m512i even1, __m512i odd1, u32 shift)
+{
+    __m512i sum = _mm512_add_epi32(_mm512_add_epi32(channel_avx512(even0, shift), channel_avx512(odd0, shift)),
+                                   _mm512_add_epi32(channel_avx512(even1, shift), channel_avx512(odd1, shift)));
+
+    return(_mm512_srli_epi32(_mm512_add_epi32(sum, _mm512_set1_epi32(2)), 2));
+}
+
+KERNEL_TARGET("avx512f")
+internal inline __m128i chroma_avx512(__m512i r, __m512i g, __m512i b, s32 kr, s32 kg, s32 kb)
+{
+    __m512i sum = _mm512_add_epi32(_mm512_mullo_epi32(r, _mm512_set1_epi32(kr)), _mm512_mullo_epi32(g, _mm512_set1_epi32(kg)));
+    sum = _mm512_add_epi32(sum, _mm512_add_epi32(_mm512_mullo_epi32(b, _mm512_set1_epi32(kb)), _mm512_set1_epi32(128)));
+
+    return(_mm512_cvtepi32_epi8(_mm512_add_epi32(_mm512_srai_epi32(sum, 8), _mm512_set1_epi32(128))));
+}
+
+KERNEL_TARGET("avx512f")
+internal void yuv420_rows_avx512(const u32 *row0, const u32 *row1, s32 width, u8 *luma0, u8 *luma1, u8 *u, u8 *v)
+{
+    const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odd = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+
+    s32 x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m512i a0 = _mm512_loadu_si512(row0 + x);
+        __m512i b0 = _mm512_loadu_si512(row0 + x + 16);
+        __m512i a1 = _mm512_loadu_si512(row1 + x);
+        __m512i b1 = _mm512_loadu_si512(row1 + x + 16);
+
+        _mm_storeu_si128((__m128i *) (luma0 + x), luma_avx512(a0));
+        _mm_storeu_si128((__m128i *) (luma0 + x + 16), luma_avx512(b0));
+        _mm_storeu_si128((__m128i *) (luma1 + x), luma_avx512(a1));
+        _mm_storeu_si128((__m128i *) (luma1 + x + 16), luma_avx512(b1));
+
+        __m512i even0 = _mm512_permutex2var_epi32(a0, even, b0);
+        __m512i odd0 = _mm512_permutex2var_epi32(a0, odd, b0);
+        __m512i even1 = _mm512_permutex2var_epi32(a1, even, b1);
+        __m512i odd1 = _mm512_permutex2var_epi32(a1, odd, b1);
+
+        __m512i r = average_avx512(even0, odd0, even1, odd1, 16);
+        __m512i g = average_avx512(even0, odd0, even1, odd1, 8);
+        __m512i b = average_avx512(even0, odd0, even1, odd1, 0);
+        _mm_storeu_si128((__m128i *) (u + x / 2), chroma_avx512(r, g, b, -38, -74, 112));
+        _mm_storeu_si128((__m128i *) (v + x / 2), chroma_avx512(r, g, b, 112, -94, -18));
+    }
+
+    for (; x < width; x += 2) kernel_yuv420_pair(row0, row1, x, luma0, luma1, u, v);
+}
+
+extern const Raster_Kernels raster_kernels_avx512 = {
+    "avx512",
+    crossings_avx512,
+    xor_popcount_avx512,
+    fill_texels_avx512,
+    yuv420_rows_avx512,
+};
+
+#endif // RASTER_KERNELS_X86
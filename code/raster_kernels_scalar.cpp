@@ -0,0 +1,55 @@
+#include "raster_kernels.h"
+
+// @Note: Plain C++ versions, these are what every other variant has to agree with and what
+// runs on anything we don't have a better variant for.
+
+internal u32 crossings_scalar(const Line_Group *group, u32 lanes, s32 x, s32 y)
+{
+    u32 hits = 0;
+
+    for (u32 i = 0; i < TILE_GROUP_LINES && (lanes >> i) != 0; ++i) {
+        if (!(lanes & (1u << i))) continue;
+
+        s32 x0 = group->x0[i];
+        s32 y0 = group->y0[i];
+        s32 x1 = group->x1[i];
+        s32 y1 = group->y1[i];
+        if ((y0 <= y) == (y1 <= y)) continue;
+
+        s64 lhs = (s64) (y - y0) * (x1 - x0);
+        s64 rhs = (s64) (x - x0) * (y1 - y0);
+        if (y1 > y0 ? lhs <= rhs : lhs >= rhs) hits |= 1u << i;
+    }
+
+    return(hits);
+}
+
+internal u32 xor_popcount_scalar(const u64 *a, const u64 *b, u64 *out, size_t words)
+{
+    u32 count = 0;
+
+    for (size_t i = 0; i < words; ++i) {
+        out[i] = a[i] ^ b[i];
+        count += kernel_popcount64(out[i]);
+    }
+
+    return(count);
+}
+
+internal void fill_texels_scalar(const u64 *row, s32 x_first, s32 x_last, u32 *pixels, u32 color)
+{
+    for (s32 x = x_first; x <= x_last; ++x) pixels[x] = kernel_texel(row, x, color);
+}
+
+internal void yuv420_rows_scalar(const u32 *row0, const u32 *row1, s32 width, u8 *luma0, u8 *luma1, u8 *u, u8 *v)
+{
+    for (s32 x = 0; x < width; x += 2) kernel_yuv420_pair(row0, row1, x, luma0, luma1, u, v);
+}
+
+extern const Raster_Kernels raster_kernels_scalar = {
+    "scalar",
+    crossings_scalar,
+    xor_popcount_scalar,
+    fill_texels_scalar,
+    yuv420_rows_scalar,
+};
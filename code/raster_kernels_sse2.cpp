@@ -0,0 +1,208 @@
+#include "raster_kernels.h"
+
+#ifdef RASTER_KERNELS_X86
+#include <emmintrin.h>
+
+// @Note: SSE2 has no signed 32 x 32 -> 64 multiply, we take the unsigned one and correct
+// for the operands that are negative. 'a' and 'b' are sign extended to 64 bits.
+KERNEL_TARGET("sse2")
+internal inline __m128i mul_s64_sse2(__m128i a, __m128i b)
+{
+    __m128i product = _mm_mul_epu32(a, b);
+    __m128i a_sign = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128i b_sign = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128i fix = _mm_add_epi64(_mm_and_si128(a_sign, b), _mm_and_si128(b_sign, a));
+
+    return(_mm_sub_epi64(product, _mm_slli_epi64(fix, 32)));
+}
+
+KERNEL_TARGET("sse2")
+internal inline __m128i extend_lo_sse2(__m128i v)
+{
+    return(_mm_unpacklo_epi32(v, _mm_srai_epi32(v, 31)));
+}
+
+KERNEL_TARGET("sse2")
+internal inline __m128i extend_hi_sse2(__m128i v)
+{
+    return(_mm_unpackhi_epi32(v, _mm_srai_epi32(v, 31)));
+}
+
+// @Note: Returns a bit per 64 bit lane that is set when the line misses. For lines going up
+// (along y) a hit is 'rhs - lhs >= 0', for lines going down we negate first.
+KERNEL_TARGET("sse2")
+internal inline u32 misses_sse2(__m128i a, __m128i b, __m128i c, __m128i d, __m128i down)
+{
+    __m128i lhs = mul_s64_sse2(a, b);
+    __m128i rhs = mul_s64_sse2(c, d);
+    __m128i diff = _mm_sub_epi64(rhs, lhs);
+    diff = _mm_sub_epi64(_mm_xor_si128(diff, down), down);
+
+    return((u32) _mm_movemask_pd(_mm_castsi128_pd(diff)));
+}
+
+KERNEL_TARGET("sse2")
+internal u32 crossings_sse2(const Line_Group *group, u32 lanes, s32 x, s32 y)
+{
+    __m128i vx = _mm_set1_epi32(x);
+    __m128i vy = _mm_set1_epi32(y);
+    u32 hits = 0;
+
+    for (u32 i = 0; i < TILE_GROUP_LINES; i += 4) {
+        u32 chunk = (lanes >> i) & 0xF;
+        if (chunk == 0) continue;
+
+        __m128i x0 = _mm_loadu_si128((const __m128i *) &group->x0[i]);
+        __m128i y0 = _mm_loadu_si128((const __m128i *) &group->y0[i]);
+        __m128i x1 = _mm_loadu_si128((const __m128i *) &group->x1[i]);
+        __m128i y1 = _mm_loadu_si128((const __m128i *) &group->y1[i]);
+
+        __m128i span = _mm_xor_si128(_mm_cmpgt_epi32(y0, vy), _mm_cmpgt_epi32(y1, vy));
+        chunk &= (u32) _mm_movemask_ps(_mm_castsi128_ps(span));
+        if (chunk == 0) continue;
+
+        __m128i a = _mm_sub_epi32(vy, y0);
+        __m128i b = _mm_sub_epi32(x1, x0);
+        __m128i c = _mm_sub_epi32(vx, x0);
+        __m128i d = _mm_sub_epi32(y1, y0);
+        __m128i down = _mm_cmpgt_epi32(y0, y1);
+
+        u32 misses = misses_sse2(extend_lo_sse2(a), extend_lo_sse2(b), extend_lo_sse2(c), extend_lo_sse2(d), extend_lo_sse2(down));
+        misses |= misses_sse2(extend_hi_sse2(a), extend_hi_sse2(b), extend_hi_sse2(c), extend_hi_sse2(d), extend_hi_sse2(down)) << 2;
+
+        hits |= (chunk & ~misses) << i;
+    }
+
+    return(hits);
+}
+
+KERNEL_TARGET("sse2")
+internal u32 xor_popcount_sse2(const u64 *a, const u64 *b, u64 *out, size_t words)
+{
+    const __m128i m1 = _mm_set1_epi8(0x55);
+    const __m128i m2 = _mm_set1_epi8(0x33);
+    const __m128i m4 = _mm_set1_epi8(0x0F);
+    
+    __m128i total = _mm_setzero_si128();
+    size_t i = 0;
+    
+    for (; i + 2 <= words; i += 2) {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *) &a[i]), _mm_loadu_si128((const __m128i *) &b[i]));
+        _mm_storeu_si128((__m128i *) &out[i], x);
+
+        x = _mm_sub_epi64(x, _mm_and_si128(_mm_srli_epi64(x, 1), m1));
+        x = _mm_add_epi64(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi64(x, 2), m2));
+        x = _mm_and_si128(_mm_add_epi64(x, _mm_srli_epi64(x, 4)), m4);
+        total = _mm_add_epi64(total, _mm_sad_epu8(x, _mm_setzero_si128()));
+    }
+
+    u64 sums[2];
+    _mm_storeu_si128((__m128i *) sums, total);
+    u32 count = (u32) (sums[0] + sums[1]);
+
+    for (; i < words; ++i) {
+        out[i] = a[i] ^ b[i];
+        count += kernel_popcount64(out[i]);
+    }
+
+    return(count);
+}
+
+// @Note: Four texels at a time, starting at a multiple of four so they never straddle two words.
+KERNEL_TARGET("sse2")
+internal void fill_texels_sse2(const u64 *row, s32 x_first, s32 x_last, u32 *pixels, u32 color)
+{
+    const __m128i lane_bits = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i vcolor = _mm_set1_epi32((int) color);
+    
+    s32 x = x_first;
+    for (; x <= x_last && x % 4 != 0; ++x) pixels[x] = kernel_texel(row, x, color);
+    
+    for (; x + 3 <= x_last; x += 4) {
+        __m128i bits = _mm_set1_epi32((int) ((row[x / 64] >> (x % 64)) & 0xF));
+        __m128i filled = _mm_cmpeq_epi32(_mm_and_si128(bits, lane_bits), lane_bits);
+        _mm_storeu_si128((__m128i *) &pixels[x], _mm_and_si128(filled, vcolor));
+    }
+
+    for (; x <= x_last; ++x) pixels[x] = kernel_texel(row, x, color);
+}
+
+// @Note: Eight pixels into one 16 bit lane per pixel for each channel.
+KERNEL_TARGET("sse2")
+internal inline void channels_sse2(const u32 *pixels, __m128i *r, __m128i *g, __m128i *b)
+{
+    const __m128i low = _mm_set1_epi32(0xFF);
+    __m128i p0 = _mm_loadu_si128((const __m128i *) pixels);
+    __m128i p1 = _mm_loadu_si128((const __m128i *) (pixels + 4));
+
+    *r = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 16), low), _mm_and_si128(_mm_srli_epi32(p1, 16), low));
+    *g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0, 8), low), _mm_and_si128(_mm_srli_epi32(p1, 8), low));
+    *b = _mm_packs_epi32(_mm_and_si128(p0, low), _mm_and_si128(p1, low));
+}
+
+// @Note: The sum only fits 16 bits unsigned, the wrapping adds and the logical shift keep it
+// that way.
+KERNEL_TARGET("sse2")
+internal inline __m128i luma_sse2(__m128i r, __m128i g, __m128i b)
+{
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129)));
+    sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+
+    return(_mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16)));
+}
+
+// @Note: Averages of the 2x2 blocks of two rows of 16 pixels, 'lo' having the first 8 of each.
+KERNEL_TARGET("sse2")
+internal inline __m128i average_sse2(__m128i row0_lo, __m128i row0_hi, __m128i row1_lo, __m128i row1_hi)
+{
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i lo = _mm_madd_epi16(_mm_add_epi16(row0_lo, row1_lo), ones);
+    __m128i hi = _mm_madd_epi16(_mm_add_epi16(row0_hi, row1_hi), ones);
+
+    return(_mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(lo, hi), _mm_set1_epi16(2)), 2));
+}
+
+KERNEL_TARGET("sse2")
+internal inline __m128i chroma_sse2(__m128i r, __m128i g, __m128i b, s32 kr, s32 kg, s32 kb)
+{
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16((short) kr)), _mm_mullo_epi16(g, _mm_set1_epi16((short) kg)));
+    sum = _mm_add_epi16(sum, _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16((short) kb)), _mm_set1_epi16(128)));
+
+    return(_mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128)));
+}
+
+KERNEL_TARGET("sse2")
+internal void yuv420_rows_sse2(const u32 *row0, const u32 *row1, s32 width, u8 *luma0, u8 *luma1, u8 *u, u8 *v)
+{
+    s32 x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i r0[2], g0[2], b0[2], r1[2], g1[2], b1[2];
+        for (s32 half = 0; half < 2; ++half) {
+            channels_sse2(row0 + x + 8 * half, &r0[half], &g0[half], &b0[half]);
+            channels_sse2(row1 + x + 8 * half, &r1[half], &g1[half], &b1[half]);
+        }
+
+        _mm_storeu_si128((__m128i *) (luma0 + x), _mm_packus_epi16(luma_sse2(r0[0], g0[0], b0[0]), luma_sse2(r0[1], g0[1], b0[1])));
+        _mm_storeu_si128((__m128i *) (luma1 + x), _mm_packus_epi16(luma_sse2(r1[0], g1[0], b1[0]), luma_sse2(r1[1], g1[1], b1[1])));
+
+        __m128i r = average_sse2(r0[0], r0[1], r1[0], r1[1]);
+        __m128i g = average_sse2(g0[0], g0[1], g1[0], g1[1]);
+        __m128i b = average_sse2(b0[0], b0[1], b1[0], b1[1]);
+        __m128i vu = chroma_sse2(r, g, b, -38, -74, 112);
+        __m128i vv = chroma_sse2(r, g, b, 112, -94, -18);
+        _mm_storel_epi64((__m128i *) (u + x / 2), _mm_packus_epi16(vu, vu));
+        _mm_storel_epi64((__m128i *) (v + x / 2), _mm_packus_epi16(vv, vv));
+    }
+
+    for (; x < width; x += 2) kernel_yuv420_pair(row0, row1, x, luma0, luma1, u, v);
+}
+
+extern const Raster_Kernels raster_kernels_sse2 = {
+    "sse2",
+    crossings_sse2,
+    xor_popcount_sse2,
+    fill_texels_sse2,
+    yuv420_rows_sse2,
+};
+
+#endif // RASTER_KERNELS_X86